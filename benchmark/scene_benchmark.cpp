@@ -0,0 +1,179 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Benchmark of kuu::opengl::Scene update and submit.
+ * ---------------------------------------------------------------- */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include <glm/gtc/quaternion.hpp>
+#include "opengl_scene.h"
+
+using namespace kuu::opengl;
+
+namespace
+{
+
+/* ---------------------------------------------------------------- *
+   An object that is laid out like the kuu::opengl::Quad: a shared
+   pointer of an object holding a shared pointer of its data. The
+   Quad itself cannot be used as it needs an OpenGL context.
+ * ---------------------------------------------------------------- */
+class Node
+{
+public:
+    using Ptr = std::shared_ptr<Node>;
+
+    Node(const glm::vec3& position, float rotationRate)
+        : d(std::make_shared<Data>())
+    {
+        d->position     = position;
+        d->rotationRate = rotationRate;
+    }
+
+    void update(float elapsed)
+    {
+        const float angleChange = d->rotationRate * elapsed;
+        d->yaw *= glm::angleAxis(glm::radians(angleChange),
+                                 glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    glm::mat4 model() const
+    {
+        glm::mat4 transform = glm::mat4_cast(d->yaw);
+        transform[3] = glm::vec4(d->position, 1.0f);
+        return transform;
+    }
+
+private:
+    struct Data
+    {
+        glm::vec3 position;
+        glm::quat yaw;
+        float rotationRate = 0.0f;
+        std::uint32_t meshId = 0;
+        Scene::Bounds bounds;
+    };
+    std::shared_ptr<Data> d;
+};
+
+// Shorthand aliases of clock
+using Clock = std::chrono::steady_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   Runs the update and submit of N objects for a count of frames
+   with both the scene and a vector of node pointers. The submit
+   writes the model-view-projection matrix of each object into a
+   draw list, which is the per-object data the renderer uploads.
+
+   The node vector is shuffled to model a scene that has been edited
+   over time so that the nodes are not in allocation order.
+
+   Usage: scene-benchmark [object count] [frame count]
+ * ---------------------------------------------------------------- */
+int main(int argc, char* argv[])
+{
+    const int objectCount = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int frameCount  = argc > 2 ? std::atoi(argv[2]) : 100;
+    if (objectCount < 1 || objectCount > Scene::MaxObjectCount)
+    {
+        std::cerr << "Object count must be from 1 to "
+                  << Scene::MaxObjectCount << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (frameCount < 1)
+    {
+        std::cerr << "Frame count must be at least 1" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const float elapsed   = 16.0f;
+    const float rate      = 180.0f / 1000.0f;
+    const glm::mat4 viewProjection(1.0f);
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> coordinate(-10.0f, 10.0f);
+
+    std::vector<glm::mat4> drawList(objectCount);
+    float checksum = 0.0f;
+
+    // ---------------------------------------------------------------
+    // Vector of node pointers.
+
+    std::vector<Node::Ptr> nodes;
+    for (int i = 0; i < objectCount; ++i)
+    {
+        const glm::vec3 position(coordinate(random),
+                                 coordinate(random),
+                                 coordinate(random));
+        nodes.push_back(std::make_shared<Node>(position, rate));
+    }
+    std::shuffle(nodes.begin(), nodes.end(), random);
+
+    const Clock::time_point nodeStart = Clock::now();
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        for (const Node::Ptr& node : nodes)
+            node->update(elapsed);
+
+        std::size_t i = 0;
+        for (const Node::Ptr& node : nodes)
+            drawList[i++] = viewProjection * node->model();
+        checksum += drawList[objectCount / 2][0][0];
+    }
+    const double nodeTime =
+        Milliseconds(Clock::now() - nodeStart).count() / frameCount;
+
+    // ---------------------------------------------------------------
+    // Scene.
+
+    Scene scene;
+    for (int i = 0; i < objectCount; ++i)
+    {
+        const glm::vec3 position(coordinate(random),
+                                 coordinate(random),
+                                 coordinate(random));
+        if (scene.create(position, rate, 0) == Scene::InvalidHandle)
+        {
+            std::cerr << "Failed to create scene object " << i
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const Clock::time_point sceneStart = Clock::now();
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        scene.update(elapsed);
+
+        const glm::mat4* transforms = scene.transforms();
+        const int count = scene.size();
+        for (int i = 0; i < count; ++i)
+            drawList[i] = viewProjection * transforms[i];
+        checksum += drawList[objectCount / 2][0][0];
+    }
+    const double sceneTime =
+        Milliseconds(Clock::now() - sceneStart).count() / frameCount;
+
+    // ---------------------------------------------------------------
+    // Results
+
+    std::cout << objectCount << " objects, "
+              << frameCount  << " frames" << std::endl
+              << "vector of pointers: " << nodeTime  << " ms/frame"
+              << std::endl
+              << "scene:              " << sceneTime << " ms/frame"
+              << std::endl
+              << "speedup:            " << nodeTime / sceneTime
+              << std::endl
+              << "(checksum " << checksum << ")" << std::endl;
+
+    return EXIT_SUCCESS;
+}
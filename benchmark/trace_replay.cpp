@@ -0,0 +1,150 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Replay of kuu::opengl::Trace file for benchmarking.
+ * ---------------------------------------------------------------- */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "opengl_resource_registry.h"
+#include "opengl_trace.h" // needs to be before QOpenGL* includes
+#include <QtCore/QCommandLineParser>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QSurfaceFormat>
+
+using namespace kuu::opengl;
+
+namespace
+{
+
+// Shorthand aliases of clock
+using Clock = std::chrono::steady_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   Replays a recorded trace on an offscreen context as fast as
+   possible. Each frame is finished with glFinish() so the frame
+   time contains both the CPU submit and the GPU execution. The
+   first frame is reported on its own as it contains the creation
+   of the OpenGL objects.
+
+   Usage: trace-replay [--per-frame] <trace file>
+ * ---------------------------------------------------------------- */
+int main(int argc, char* argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace", "Trace file to replay.");
+    const QCommandLineOption perFrameOption(
+        "per-frame",
+        "Prints the time of each frame.");
+    parser.addOption(perFrameOption);
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(EXIT_FAILURE);
+
+    // Create the OpenGL context without fixed pipeline. The default
+    // framebuffer of the trace is an offscreen framebuffer so the
+    // surface does not need to be multisampled nor double buffered.
+    QSurfaceFormat openglFormat;
+    openglFormat.setVersion(3, 3);
+    openglFormat.setProfile(QSurfaceFormat::CoreProfile);
+
+    QOffscreenSurface surface;
+    surface.setFormat(openglFormat);
+    surface.create();
+
+    QOpenGLContext context;
+    context.setFormat(openglFormat);
+    if (!context.create() || !context.makeCurrent(&surface))
+    {
+        std::cerr << "Failed to create OpenGL context" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+#ifdef _WIN32
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK)
+    {
+        std::cerr << "Failed to initialize GLEW." << std::endl;
+        return EXIT_FAILURE;
+    }
+#endif
+
+    const std::string renderer =
+        reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+
+    std::vector<double> frameTimes;
+    {
+        TracePlayer player(
+            parser.positionalArguments().front().toStdString());
+        if (!player.isValid())
+            return EXIT_FAILURE;
+
+        for (;;)
+        {
+            const Clock::time_point start = Clock::now();
+            const bool played = player.playFrame();
+            glFinish();
+            if (!played)
+                break;
+
+            const double frameTime =
+                Milliseconds(Clock::now() - start).count();
+            frameTimes.push_back(frameTime);
+
+            if (parser.isSet(perFrameOption))
+                std::cout << "frame " << frameTimes.size() << ": "
+                          << frameTime << " ms ("
+                          << player.frameWidth() << " x "
+                          << player.frameHeight() << ")"
+                          << std::endl;
+        }
+    }
+
+    ResourceRegistry::instance().reportLeaks();
+    context.doneCurrent();
+
+    if (frameTimes.empty())
+    {
+        std::cerr << "Trace has no frames" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // ---------------------------------------------------------------
+    // Results. The first frame is left out from the statistics.
+
+    std::cout << frameTimes.size() << " frames, renderer "
+              << renderer << std::endl
+              << "first frame: " << frameTimes.front() << " ms"
+              << std::endl;
+
+    std::vector<double> times(frameTimes.begin() + 1,
+                              frameTimes.end());
+    if (times.empty())
+        return EXIT_SUCCESS;
+
+    std::sort(times.begin(), times.end());
+    double total = 0.0;
+    for (double time : times)
+        total += time;
+
+    std::cout << "min:    " << times.front() << " ms" << std::endl
+              << "median: " << times[times.size() / 2] << " ms"
+              << std::endl
+              << "mean:   " << total / times.size() << " ms"
+              << std::endl
+              << "max:    " << times.back() << " ms" << std::endl;
+
+    return EXIT_SUCCESS;
+}
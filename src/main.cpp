@@ -3,25 +3,145 @@
     Desc:   Definition of GLWidget multithread example main entry.
  * -----------------------------------------------------------------*/
 
+#include <cstdlib>
+#include <iostream>
+#include <QtCore/QCommandLineParser>
 #include <QtGui/QIcon>
 #include "opengl_widget.h" // needs to be before QOpenGL* includes
+#include "opengl_window.h"
+#include "opengl_startup.h"
+#include "opengl_trace.h"
 #include <QtOpengl/QGLFormat>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QDesktopWidget>
 
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
-
     using namespace kuu;
     using namespace kuu::opengl;
 
-    // Create the OpenGL format without fixed pipeline
-    QGLFormat openglFormat;
-    openglFormat.setVersion(3, 3);
-    openglFormat.setProfile(QGLFormat::CoreProfile);
-    openglFormat.setDoubleBuffer(true);
-    openglFormat.setSampleBuffers(true);
+    // Prepare the scene assets on a worker thread while the
+    // application and the window are created.
+    Startup& startup = Startup::instance();
+    startup.mark("main");
+    startup.prepareAssets();
+
+    QApplication app(argc, argv);
+    startup.mark("application created");
+
+    // Parse the command line. The backend is either the QGLWidget
+    // based widget or the QWindow based window.
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption backendOption(
+        "backend",
+        "Rendering backend, 'widget' (default) or 'window'.",
+        "backend",
+        "widget");
+    parser.addOption(backendOption);
+    const QCommandLineOption frameBudgetOption(
+        "frame-budget",
+        "Target frame time in milliseconds. Enables the adaptive "
+        "resolution.",
+        "milliseconds",
+        "0");
+    parser.addOption(frameBudgetOption);
+    const QCommandLineOption framesInFlightOption(
+        "frames-in-flight",
+        "Maximum count of frames the CPU can run ahead of the GPU, "
+        "from 1 to 3.",
+        "frames",
+        "2");
+    parser.addOption(framesInFlightOption);
+    const QCommandLineOption onDemandOption(
+        "on-demand",
+        "Render only when the scene is animated or has changed.");
+    parser.addOption(onDemandOption);
+    const QCommandLineOption antiAliasingOption(
+        "aa",
+        "Anti-aliasing mode, 'off', 'msaa' (default) or 'fxaa'.",
+        "mode",
+        "msaa");
+    parser.addOption(antiAliasingOption);
+    const QCommandLineOption samplesOption(
+        "samples",
+        "Sample count of the MSAA.",
+        "samples",
+        "4");
+    parser.addOption(samplesOption);
+    const QCommandLineOption traceOption(
+        "trace",
+        "Records the OpenGL commands into the trace file. The trace "
+        "can be replayed with trace-replay.",
+        "file");
+    parser.addOption(traceOption);
+    const QCommandLineOption traceFramesOption(
+        "trace-frames",
+        "Count of frames to record, 0 (default) records until exit.",
+        "frames",
+        "0");
+    parser.addOption(traceFramesOption);
+    const QCommandLineOption glDebugOption(
+        "gl-debug",
+        "Requests an OpenGL debug context and prints the debug "
+        "messages. Only the window backend can request the context.");
+    parser.addOption(glDebugOption);
+    const QCommandLineOption startupTimelineOption(
+        "startup-timeline",
+        "Writes the startup timeline (process start, first frame, "
+        "fully loaded) into the file.",
+        "file");
+    parser.addOption(startupTimelineOption);
+    parser.process(app);
+
+    const QString backend = parser.value(backendOption);
+    if (backend != "widget" && backend != "window")
+    {
+        std::cerr << "Unknown backend "
+                  << backend.toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const QString antiAliasingName = parser.value(antiAliasingOption);
+    Thread::AntiAliasing antiAliasing = Thread::AntiAliasing::Msaa;
+    if (antiAliasingName == "off")
+        antiAliasing = Thread::AntiAliasing::Off;
+    else if (antiAliasingName == "fxaa")
+        antiAliasing = Thread::AntiAliasing::Fxaa;
+    else if (antiAliasingName != "msaa")
+    {
+        std::cerr << "Unknown anti-aliasing mode "
+                  << antiAliasingName.toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The rendering thread starts with these so that the first
+    // frames are already rendered (and traced) with them.
+    Thread::Settings settings;
+    settings.targetFrameTime =
+        parser.value(frameBudgetOption).toDouble();
+    settings.maxFramesInFlight =
+        parser.value(framesInFlightOption).toInt();
+    settings.onDemand = parser.isSet(onDemandOption);
+    settings.antiAliasing = antiAliasing;
+    settings.samples = parser.value(samplesOption).toInt();
+
+    if (parser.isSet(startupTimelineOption))
+        startup.setTimelineFile(
+            parser.value(startupTimelineOption).toStdString());
+
+    // Start recording before the rendering thread creates the
+    // OpenGL objects.
+    if (parser.isSet(traceOption))
+    {
+        const int traceFrames =
+            parser.value(traceFramesOption).toInt();
+        if (!Trace::instance().start(
+                parser.value(traceOption).toStdString(), traceFrames))
+        {
+            return EXIT_FAILURE;
+        }
+    }
 
     // Calculate the position of the widget. The widget should be
     // located so that the center is also at the center of desktop.
@@ -31,13 +151,50 @@ int main(int argc, char *argv[])
         desktop->width()  / 2 - size.width()  / 2,
         desktop->height() / 2 - size.height() / 2);
 
-    // Create the OpenGL widget
-    Widget::Ptr widget = std::make_shared<Widget>(openglFormat);
-    widget->setWindowIcon(QIcon("://icons/application_icon.png"));
-    widget->resize(size);
-    widget->move(position);
-    widget->show();
-    widget->startThread();
+    // Create the OpenGL window or widget
+    Window::Ptr window;
+    Widget::Ptr widget;
+    if (backend == "window")
+    {
+        // Create the OpenGL format without fixed pipeline. The
+        // default framebuffer is single sampled as the anti-aliasing
+        // is done by the rendering thread.
+        QSurfaceFormat openglFormat;
+        openglFormat.setVersion(3, 3);
+        openglFormat.setProfile(QSurfaceFormat::CoreProfile);
+        openglFormat.setSwapBehavior(QSurfaceFormat::DoubleBuffer);
+        if (parser.isSet(glDebugOption))
+            openglFormat.setOption(QSurfaceFormat::DebugContext);
+
+        window = std::make_shared<Window>(openglFormat);
+        window->setIcon(QIcon("://icons/application_icon.png"));
+        window->resize(size);
+        window->setPosition(position);
+        window->show();
+        startup.mark("window shown");
+        window->startThread(settings);
+    }
+    else
+    {
+        // Create the OpenGL format without fixed pipeline. The
+        // default framebuffer is single sampled as the anti-aliasing
+        // is done by the rendering thread.
+        QGLFormat openglFormat;
+        openglFormat.setVersion(3, 3);
+        openglFormat.setProfile(QGLFormat::CoreProfile);
+        openglFormat.setDoubleBuffer(true);
+        if (parser.isSet(glDebugOption))
+            std::cerr << "Debug context is not supported by the "
+                      << "widget backend" << std::endl;
+
+        widget = std::make_shared<Widget>(openglFormat);
+        widget->setWindowIcon(QIcon("://icons/application_icon.png"));
+        widget->resize(size);
+        widget->move(position);
+        widget->show();
+        startup.mark("window shown");
+        widget->startThread(settings);
+    }
 
     return app.exec();
 }
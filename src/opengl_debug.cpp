@@ -0,0 +1,493 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::Debug class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_debug.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <QtGui/QOpenGLContext>
+
+// KHR_debug definitions that are missing from OpenGL 3.3 headers.
+#ifndef APIENTRY
+    #define APIENTRY
+#endif
+#ifndef GL_DEBUG_OUTPUT
+    #define GL_DEBUG_OUTPUT                 0x92E0
+#endif
+#ifndef GL_DEBUG_OUTPUT_SYNCHRONOUS
+    #define GL_DEBUG_OUTPUT_SYNCHRONOUS     0x8242
+#endif
+#ifndef GL_CONTEXT_FLAG_DEBUG_BIT
+    #define GL_CONTEXT_FLAG_DEBUG_BIT       0x00000002
+#endif
+#ifndef GL_DEBUG_SOURCE_API
+    #define GL_DEBUG_SOURCE_API             0x8246
+    #define GL_DEBUG_SOURCE_WINDOW_SYSTEM   0x8247
+    #define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+    #define GL_DEBUG_SOURCE_THIRD_PARTY     0x8249
+    #define GL_DEBUG_SOURCE_APPLICATION     0x824A
+#endif
+#ifndef GL_DEBUG_TYPE_ERROR
+    #define GL_DEBUG_TYPE_ERROR             0x824C
+    #define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+    #define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR  0x824E
+    #define GL_DEBUG_TYPE_PORTABILITY       0x824F
+    #define GL_DEBUG_TYPE_PERFORMANCE       0x8250
+#endif
+#ifndef GL_DEBUG_SEVERITY_HIGH
+    #define GL_DEBUG_SEVERITY_HIGH          0x9146
+    #define GL_DEBUG_SEVERITY_MEDIUM        0x9147
+    #define GL_DEBUG_SEVERITY_LOW           0x9148
+#endif
+#ifndef GL_DEBUG_SEVERITY_NOTIFICATION
+    #define GL_DEBUG_SEVERITY_NOTIFICATION  0x826B
+#endif
+#ifndef GL_BUFFER
+    #define GL_BUFFER                       0x82E0
+    #define GL_SHADER                       0x82E1
+    #define GL_PROGRAM                      0x82E2
+    #define GL_QUERY                        0x82E3
+#endif
+#ifndef GL_VERTEX_ARRAY
+    #define GL_VERTEX_ARRAY                 0x8074
+#endif
+#ifndef GL_TEXTURE
+    #define GL_TEXTURE                      0x1702
+#endif
+
+namespace kuu
+{
+namespace opengl
+{
+
+namespace
+{
+
+// KHR_debug function types.
+typedef void (APIENTRY *DebugProc)(GLenum source,
+                                   GLenum type,
+                                   GLuint id,
+                                   GLenum severity,
+                                   GLsizei length,
+                                   const GLchar* message,
+                                   const void* userParam);
+typedef void (APIENTRY *DebugMessageCallbackProc)(
+    DebugProc callback, const void* userParam);
+typedef void (APIENTRY *DebugMessageControlProc)(
+    GLenum source, GLenum type, GLenum severity,
+    GLsizei count, const GLuint* ids, GLboolean enabled);
+typedef void (APIENTRY *ObjectLabelProc)(
+    GLenum identifier, GLuint name, GLsizei length,
+    const GLchar* label);
+
+// Count of the error messages. The callback can be called from a
+// driver thread.
+std::atomic<int> errorMessages(0);
+
+/* ---------------------------------------------------------------- *
+   Returns the name of the message source.
+ * ---------------------------------------------------------------- */
+const char* sourceName(GLenum source)
+{
+    switch (source)
+    {
+        case GL_DEBUG_SOURCE_API:             return "api";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "window system";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+        case GL_DEBUG_SOURCE_THIRD_PARTY:     return "third party";
+        case GL_DEBUG_SOURCE_APPLICATION:     return "application";
+        default:                              return "other";
+    }
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the name of the message type.
+ * ---------------------------------------------------------------- */
+const char* typeName(GLenum type)
+{
+    switch (type)
+    {
+        case GL_DEBUG_TYPE_ERROR:               return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "undefined";
+        case GL_DEBUG_TYPE_PORTABILITY:         return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE:         return "performance";
+        default:                                return "message";
+    }
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the name of the message severity.
+ * ---------------------------------------------------------------- */
+const char* severityName(GLenum severity)
+{
+    switch (severity)
+    {
+        case GL_DEBUG_SEVERITY_HIGH:   return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_LOW:    return "low";
+        default:                       return "notification";
+    }
+}
+
+/* ---------------------------------------------------------------- *
+   Prints the debug message into standard error stream.
+ * ---------------------------------------------------------------- */
+void APIENTRY debugMessage(GLenum source,
+                           GLenum type,
+                           GLuint /*id*/,
+                           GLenum severity,
+                           GLsizei length,
+                           const GLchar* message,
+                           const void* /*userParam*/)
+{
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+        return;
+
+    if (type == GL_DEBUG_TYPE_ERROR)
+        errorMessages++;
+
+    const std::string text = length < 0
+        ? std::string(message)
+        : std::string(message, std::size_t(length));
+
+    std::cerr << "OpenGL " << typeName(type)
+              << " (" << sourceName(source) << ", "
+              << severityName(severity) << "): "
+              << text << std::endl;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the KHR_debug identifier of the registry category.
+ * ---------------------------------------------------------------- */
+GLenum identifier(ResourceRegistry::Category category)
+{
+    switch (category)
+    {
+        case ResourceRegistry::Buffer:       return GL_BUFFER;
+        case ResourceRegistry::VertexArray:  return GL_VERTEX_ARRAY;
+        case ResourceRegistry::Texture:      return GL_TEXTURE;
+        case ResourceRegistry::Renderbuffer: return GL_RENDERBUFFER;
+        case ResourceRegistry::Framebuffer:  return GL_FRAMEBUFFER;
+        case ResourceRegistry::Shader:       return GL_SHADER;
+        case ResourceRegistry::Program:      return GL_PROGRAM;
+        case ResourceRegistry::Query:        return GL_QUERY;
+        default:                             return 0;
+    }
+}
+
+#ifdef KUU_OPENGL_VERIFY
+
+/* ---------------------------------------------------------------- *
+   Returns the OpenGL shader info log
+ * ---------------------------------------------------------------- */
+std::string shaderInfoLog(GLuint id)
+{
+    GLint length = 0;
+    glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+
+    if (length <= 0)
+        return std::string();
+
+    std::string log;
+    log.resize(length + 1);
+    glGetShaderInfoLog(id, length, NULL, (GLchar*)log.c_str());
+
+    log.erase(std::remove(log.begin(), log.end(), '\0'), log.end());
+    return log;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the OpenGL program info log
+ * ---------------------------------------------------------------- */
+std::string programInfoLog(GLuint id)
+{
+    GLint length = 0;
+    glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
+
+    if (length <= 0)
+        return std::string();
+
+    std::string log;
+    log.resize(length + 1);
+    glGetProgramInfoLog(id, length, NULL, (GLchar*)log.c_str());
+
+    log.erase(std::remove(log.begin(), log.end(), '\0'), log.end());
+    return log;
+}
+
+#endif // KUU_OPENGL_VERIFY
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   The data of the debug subsystem.
+ * ---------------------------------------------------------------- */
+struct Debug::Data
+{
+    // Key of a pending label.
+    using Key = std::pair<int, GLuint>;
+
+    // Applies the label into the object.
+    void apply(ResourceRegistry::Category category,
+               GLuint name,
+               const std::string& label)
+    {
+        objectLabel(identifier(category), name,
+                    GLsizei(label.size()), label.c_str());
+    }
+
+    DebugMessageCallbackProc debugMessageCallback = nullptr;
+    DebugMessageControlProc debugMessageControl   = nullptr;
+    ObjectLabelProc objectLabel                   = nullptr;
+
+    std::atomic<bool> installed;   // true if callback is installed
+    std::atomic<int> syncCalls;    // count of sync-forcing calls
+
+    std::mutex mutex;                      // guards pending labels
+    std::map<Key, std::string> labels;     // pending labels
+    std::atomic<int> pendingCount;         // count of pending labels
+};
+
+/* ---------------------------------------------------------------- *
+   Returns the debug subsystem of the process.
+ * ---------------------------------------------------------------- */
+Debug& Debug::instance()
+{
+    static Debug debug;
+    return debug;
+}
+
+/* ---------------------------------------------------------------- *
+   Constructs the debug subsystem.
+ * ---------------------------------------------------------------- */
+Debug::Debug()
+    : d(std::make_shared<Data>())
+{
+    d->installed    = false;
+    d->syncCalls    = 0;
+    d->pendingCount = 0;
+}
+
+/* ---------------------------------------------------------------- *
+   Installs the callback. The functions are resolved through the
+   current context as OpenGL 3.3 headers do not declare them. With
+   KUU_OPENGL_VERIFY the messages are synchronous so that the call-
+   back is called by the failing call.
+ * ---------------------------------------------------------------- */
+bool Debug::install()
+{
+    QOpenGLContext* context = QOpenGLContext::currentContext();
+    if (!context || !context->hasExtension("GL_KHR_debug"))
+        return false;
+
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    countSyncCall();
+    const bool debugContext = (flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+#ifndef KUU_OPENGL_VERIFY
+    if (!debugContext)
+        return false;
+#endif
+
+    d->debugMessageCallback = (DebugMessageCallbackProc)
+        context->getProcAddress("glDebugMessageCallback");
+    d->debugMessageControl = (DebugMessageControlProc)
+        context->getProcAddress("glDebugMessageControl");
+    d->objectLabel = (ObjectLabelProc)
+        context->getProcAddress("glObjectLabel");
+    if (!d->debugMessageCallback ||
+        !d->debugMessageControl  ||
+        !d->objectLabel)
+    {
+        std::cerr << "Failed to resolve KHR_debug functions"
+                  << std::endl;
+        return false;
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+#ifdef KUU_OPENGL_VERIFY
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+    d->debugMessageControl(GL_DONT_CARE, GL_DONT_CARE,
+                           GL_DEBUG_SEVERITY_NOTIFICATION,
+                           0, 0, GL_FALSE);
+    d->debugMessageCallback(debugMessage, 0);
+    d->installed = true;
+
+    std::cout << "OpenGL debug output enabled"
+              << (debugContext ? "" : " (not a debug context)")
+              << std::endl;
+    return true;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns true if the callback is installed.
+ * ---------------------------------------------------------------- */
+bool Debug::isInstalled() const
+{ return d->installed; }
+
+/* ---------------------------------------------------------------- *
+   Returns the count of error messages.
+ * ---------------------------------------------------------------- */
+int Debug::errorCount() const
+{ return errorMessages; }
+
+/* ---------------------------------------------------------------- *
+   Sets the label. Shaders and programs exist after the creation,
+   the other objects after the first bind.
+ * ---------------------------------------------------------------- */
+void Debug::setLabel(ResourceRegistry::Category category,
+                     GLuint name,
+                     const std::string& label)
+{
+    if (!d->installed || name == 0)
+        return;
+
+    if (category == ResourceRegistry::Shader ||
+        category == ResourceRegistry::Program)
+    {
+        d->apply(category, name, label);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->labels[Data::Key(category, name)] = label;
+    d->pendingCount = int(d->labels.size());
+}
+
+/* ---------------------------------------------------------------- *
+   Applies the pending label of the bound object.
+ * ---------------------------------------------------------------- */
+void Debug::bound(ResourceRegistry::Category category, GLuint name)
+{
+    if (d->pendingCount == 0 || name == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+    auto it = d->labels.find(Data::Key(category, name));
+    if (it == d->labels.end())
+        return;
+
+    d->apply(category, name, it->second);
+    d->labels.erase(it);
+    d->pendingCount = int(d->labels.size());
+}
+
+/* ---------------------------------------------------------------- *
+   Removes the pending label.
+ * ---------------------------------------------------------------- */
+void Debug::removeLabel(ResourceRegistry::Category category,
+                        GLuint name)
+{
+    if (d->pendingCount == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->labels.erase(Data::Key(category, name));
+    d->pendingCount = int(d->labels.size());
+}
+
+/* ---------------------------------------------------------------- *
+   Sync-forcing calls.
+ * ---------------------------------------------------------------- */
+void Debug::countSyncCall()
+{ d->syncCalls++; }
+
+int Debug::takeSyncCalls()
+{ return d->syncCalls.exchange(0); }
+
+/* ---------------------------------------------------------------- *
+   Verifies the binding.
+ * ---------------------------------------------------------------- */
+void Debug::verifyBinding(GLenum binding,
+                          GLuint name,
+                          const std::string& label)
+{
+#ifdef KUU_OPENGL_VERIFY
+    GLint current = 0;
+    glGetIntegerv(binding, &current);
+    instance().countSyncCall();
+    if (GLuint(current) != name)
+        std::cerr << "Failed to bind " << label << std::endl;
+#else
+    (void) binding; (void) name; (void) label;
+#endif
+}
+
+/* ---------------------------------------------------------------- *
+   Verifies the compile status. The info log is printed on failure.
+ * ---------------------------------------------------------------- */
+void Debug::verifyCompile(GLuint shader, const std::string& label)
+{
+#ifdef KUU_OPENGL_VERIFY
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    instance().countSyncCall();
+    if (status != GL_TRUE)
+    {
+        std::cerr << "Failed to compile " << label << std::endl;
+        std::cerr << shaderInfoLog(shader) << std::endl;
+    }
+#else
+    (void) shader; (void) label;
+#endif
+}
+
+/* ---------------------------------------------------------------- *
+   Verifies the link status. The info log is printed on failure.
+ * ---------------------------------------------------------------- */
+void Debug::verifyLink(GLuint program, const std::string& label)
+{
+#ifdef KUU_OPENGL_VERIFY
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    instance().countSyncCall();
+    if (status != GL_TRUE)
+    {
+        std::cerr << "Failed to link " << label << std::endl;
+        std::cerr << programInfoLog(program) << std::endl;
+    }
+#else
+    (void) program; (void) label;
+#endif
+}
+
+/* ---------------------------------------------------------------- *
+   Validates the program.
+ * ---------------------------------------------------------------- */
+void Debug::verifyProgram(GLuint program)
+{
+#ifdef KUU_OPENGL_VERIFY
+    glValidateProgram(program);
+    GLint status = 0;
+    glGetProgramiv(program, GL_VALIDATE_STATUS, &status);
+    instance().countSyncCall();
+    if (status != GL_TRUE)
+        std::cerr << "Shader program is not valid" << std::endl;
+#else
+    (void) program;
+#endif
+}
+
+/* ---------------------------------------------------------------- *
+   Verifies the framebuffer status.
+ * ---------------------------------------------------------------- */
+void Debug::verifyFramebuffer(const std::string& label)
+{
+#ifdef KUU_OPENGL_VERIFY
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    instance().countSyncCall();
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << label << " is not complete" << std::endl;
+#else
+    (void) label;
+#endif
+}
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,108 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::Debug class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "opengl.h"
+#include "opengl_resource_registry.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A debug subsystem of the OpenGL.
+
+   The errors are reported asynchronously with the KHR_debug message
+   callback instead of asking the state after the calls. The call-
+   back is installed if the current context is a debug context or
+   if KUU_OPENGL_VERIFY is defined. The messages are printed into
+   standard error stream, notifications are ignored. The objects
+   created through the resource registry are labeled so that the
+   driver can name them in the messages. An object exists only
+   after it has been bound for the first time so the label is kept
+   pending until the bind.
+
+   The verification functions ask the state right after a call,
+   e.g. the bind status or the compile status of a shader. These
+   force the CPU to wait for the driver so they are compiled only
+   if KUU_OPENGL_VERIFY is defined, otherwise they do nothing.
+
+   The calls that force the CPU to wait for the driver, i.e. the
+   state queries and the blocking fence waits, are counted so that
+   the count per frame can be followed. Non-blocking polls, e.g. a
+   fence wait with zero timeout or a query availability check, are
+   not counted as their count depends on the pending GPU work.
+
+   Example:
+
+    // after the context is made current
+    Debug& debug = Debug::instance();
+    debug.install();
+    ...
+    glCompileShader(shader);
+    Debug::verifyCompile(shader, "Quad vertex shader");
+    ...
+    // once a frame
+    std::cout << debug.takeSyncCalls() << std::endl;
+
+ * ---------------------------------------------------------------- */
+class Debug
+{
+public:
+    // Returns the debug subsystem of the process.
+    static Debug& instance();
+
+    // Installs the debug message callback into the current context.
+    // Returns false if the callback was not installed.
+    bool install();
+    // Returns true if the callback is installed.
+    bool isInstalled() const;
+    // Returns the count of error messages.
+    int errorCount() const;
+
+    // Sets the label of the object. The label is applied when the
+    // object exists. Called by the resource registry.
+    void setLabel(ResourceRegistry::Category category,
+                  GLuint name,
+                  const std::string& label);
+    // Marks that the object has been bound and exists. The pending
+    // label of the object is applied.
+    void bound(ResourceRegistry::Category category, GLuint name);
+    // Removes the pending label of a deleted object.
+    void removeLabel(ResourceRegistry::Category category, GLuint name);
+
+    // Counts a call that forces the CPU to wait for the driver.
+    void countSyncCall();
+    // Returns the count of sync-forcing calls since the previous
+    // call and resets the count.
+    int takeSyncCalls();
+
+    // Verifies that the object is bound into the binding, e.g.
+    // GL_VERTEX_ARRAY_BINDING.
+    static void verifyBinding(GLenum binding,
+                              GLuint name,
+                              const std::string& label);
+    // Verifies the compile status of the shader.
+    static void verifyCompile(GLuint shader, const std::string& label);
+    // Verifies the link status of the program.
+    static void verifyLink(GLuint program, const std::string& label);
+    // Validates the program against the current state.
+    static void verifyProgram(GLuint program);
+    // Verifies the status of the bound framebuffer.
+    static void verifyFramebuffer(const std::string& label);
+
+private:
+    Debug();
+
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,228 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::FrameLimiter class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_frame_limiter.h"
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <vector>
+#include "opengl.h"
+#include "opengl_debug.h"
+#include "opengl_resource_registry.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+namespace
+{
+
+// Timeout of a single fence wait in nanoseconds.
+const GLuint64 WaitTimeout = 1000000000;
+// Count of timeouts before an unfinished frame is given up.
+const int MaxWaits = 5;
+
+// Clamps the frames in-flight limit from 1 to 3.
+int clampLimit(int maxFramesInFlight)
+{
+    return std::min(std::max(maxFramesInFlight, 1), 3);
+}
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   The data of the limiter.
+ * ---------------------------------------------------------------- */
+struct FrameLimiter::Data
+{
+    // A submitted frame that has not been finished yet.
+    struct Frame
+    {
+        GLsync fence;       // fence after the frame
+        GLuint query;       // timestamp of the GPU completion
+        GLint64 submitted;  // GL time of the submission
+    };
+
+    // Constructs the limiter data
+    Data(int maxFramesInFlight)
+        : maxFramesInFlight(maxFramesInFlight)
+    {}
+
+    // Finishes the oldest frame. If the frame is finished by the GPU
+    // then the latency is stored from the completion timestamp. The
+    // fence has signaled so reading the timestamp does not wait.
+    void finishOldest(bool finished)
+    {
+        const Frame& frame = frames.front();
+        ResourceRegistry& registry = ResourceRegistry::instance();
+
+        GLint available = 0;
+        if (finished)
+            glGetQueryObjectiv(frame.query, GL_QUERY_RESULT_AVAILABLE,
+                               &available);
+        if (available)
+        {
+            GLint64 completed = 0;
+            glGetQueryObjecti64v(frame.query, GL_QUERY_RESULT,
+                                 &completed);
+            const GLint64 latency =
+                std::max(completed - frame.submitted, GLint64(0));
+            latencies.push_back(double(latency) / 1.0e6);
+            queries.push_back(frame.query);
+        }
+        else
+        {
+            // The query may still be pending so it is not reused.
+            registry.deleteQuery(frame.query);
+        }
+
+        glDeleteSync(frame.fence);
+        frames.pop_front();
+    }
+
+    int maxFramesInFlight;        // frames in-flight limit
+    std::deque<Frame> frames;     // unfinished frames, oldest first
+    std::deque<double> latencies; // unread latencies
+    std::vector<GLuint> queries;  // unused timestamp queries
+};
+
+/* ---------------------------------------------------------------- *
+   Constructs the limiter.
+ * -----------------------------------------------------------------*/
+FrameLimiter::FrameLimiter(int maxFramesInFlight)
+    : d(std::make_shared<Data>(clampLimit(maxFramesInFlight)))
+{}
+
+/* ---------------------------------------------------------------- *
+   Sets the frames in-flight limit. The limit is clamped from 1 to
+   3 frames.
+ * -----------------------------------------------------------------*/
+void FrameLimiter::setMaxFramesInFlight(int maxFramesInFlight)
+{
+    d->maxFramesInFlight = clampLimit(maxFramesInFlight);
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the frames in-flight limit.
+ * -----------------------------------------------------------------*/
+int FrameLimiter::maxFramesInFlight() const
+{ return d->maxFramesInFlight; }
+
+/* ---------------------------------------------------------------- *
+   Waits for the frames. First the already finished frames are
+   collected without waiting and then the oldest frames are waited
+   until the count of unfinished frames is under the limit.
+ * -----------------------------------------------------------------*/
+void FrameLimiter::waitForFrame()
+{
+    // Collect the finished frames.
+    while (!d->frames.empty())
+    {
+        // A zero timeout only polls the fence so it is not counted
+        // as a call that waits.
+        const GLenum result =
+            glClientWaitSync(d->frames.front().fence, 0, 0);
+        if (result != GL_ALREADY_SIGNALED &&
+            result != GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        d->finishOldest(true);
+    }
+
+    // Wait until under the limit. A frame that is not finished after
+    // the maximum count of timeouts, e.g. the device is lost, is given
+    // up so that the thread is not blocked forever.
+    while (int(d->frames.size()) >= d->maxFramesInFlight)
+    {
+        GLenum result = GL_TIMEOUT_EXPIRED;
+        for (int i = 0; i < MaxWaits && result == GL_TIMEOUT_EXPIRED;
+             ++i)
+        {
+            result = glClientWaitSync(d->frames.front().fence,
+                                      GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      WaitTimeout);
+            Debug::instance().countSyncCall();
+        }
+
+        if (result == GL_TIMEOUT_EXPIRED)
+            std::cerr << "Frame was not finished in " << MaxWaits
+                      << " seconds" << std::endl;
+        else if (result == GL_WAIT_FAILED)
+            std::cerr << "Failed to wait frame fence" << std::endl;
+        d->finishOldest(result == GL_ALREADY_SIGNALED ||
+                        result == GL_CONDITION_SATISFIED);
+    }
+}
+
+/* ---------------------------------------------------------------- *
+   Inserts a fence after the submitted frame. The GL time of the
+   submission is read and a timestamp query is issued before the
+   fence so the query has a result when the fence signals.
+ * -----------------------------------------------------------------*/
+void FrameLimiter::endFrame()
+{
+    Data::Frame frame;
+    if (d->queries.empty())
+    {
+        frame.query =
+            ResourceRegistry::instance().createQuery("Frame latency");
+    }
+    else
+    {
+        frame.query = d->queries.back();
+        d->queries.pop_back();
+    }
+
+    glGetInteger64v(GL_TIMESTAMP, &frame.submitted);
+    Debug::instance().countSyncCall();
+    glQueryCounter(frame.query, GL_TIMESTAMP);
+    Debug::instance().bound(ResourceRegistry::Query, frame.query);
+
+    frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (!frame.fence)
+    {
+        std::cerr << "Failed to create frame fence" << std::endl;
+        d->queries.push_back(frame.query);
+        return;
+    }
+    d->frames.push_back(frame);
+}
+
+/* ---------------------------------------------------------------- *
+   Gets the oldest measured latency.
+ * -----------------------------------------------------------------*/
+bool FrameLimiter::latency(double& milliseconds)
+{
+    if (d->latencies.empty())
+        return false;
+
+    milliseconds = d->latencies.front();
+    d->latencies.pop_front();
+    return true;
+}
+
+/* ---------------------------------------------------------------- *
+   Deletes the fences and the queries. OpenGL context must be
+   current.
+ * -----------------------------------------------------------------*/
+void FrameLimiter::clear()
+{
+    ResourceRegistry& registry = ResourceRegistry::instance();
+    for (const Data::Frame& frame : d->frames)
+    {
+        glDeleteSync(frame.fence);
+        registry.deleteQuery(frame.query);
+    }
+    for (GLuint query : d->queries)
+        registry.deleteQuery(query);
+    d->frames.clear();
+    d->queries.clear();
+    d->latencies.clear();
+}
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,77 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::FrameLimiter class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A limiter of the frames in-flight. A fence is inserted after
+   each submitted frame and before starting a new frame the limiter
+   waits until the count of unfinished frames is under the limit.
+   This stops the CPU from running ahead of the GPU and so keeps
+   the input-to-display latency bounded.
+
+   The limiter also measures the latency from the frame submission
+   into the GPU completion. The GL time is read when the frame is
+   submitted and a timestamp query is issued after the frame. The
+   GPU writes the timestamp when the frame is complete. The query is
+   read once the fence of the frame has signaled so the measurement
+   does not wait for the GPU.
+
+   A frame that the GPU does not finish in five seconds, e.g. after
+   a device loss, is given up with an error instead of waiting
+   forever.
+
+   The OpenGL context must be current when calling the functions.
+
+   Example:
+
+    FrameLimiter limiter(2);
+    ...
+    limiter.waitForFrame();
+    // render and swap buffers
+    limiter.endFrame();
+
+    double ms = 0.0;
+    while (limiter.latency(ms))
+        std::cout << "Latency: " << ms << " ms" << std::endl;
+
+ * ---------------------------------------------------------------- */
+class FrameLimiter
+{
+public:
+    // Constructs the limiter. The limit is from 1 to 3.
+    FrameLimiter(int maxFramesInFlight = 2);
+
+    // Sets the frames in-flight limit from 1 to 3.
+    void setMaxFramesInFlight(int maxFramesInFlight);
+    // Returns the frames in-flight limit.
+    int maxFramesInFlight() const;
+
+    // Waits until there is less unfinished frames than the limit.
+    void waitForFrame();
+    // Inserts a fence after the submitted frame.
+    void endFrame();
+
+    // Gets the oldest measured submit-to-complete latency in milli-
+    // seconds. Returns false if there is no measured latency.
+    bool latency(double& milliseconds);
+
+    // Deletes the fences of the unfinished frames and the queries.
+    void clear();
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
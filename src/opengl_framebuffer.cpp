@@ -0,0 +1,210 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::Framebuffer class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_framebuffer.h"
+#include "opengl_debug.h"
+#include "opengl_resource_registry.h"
+#include "opengl_trace.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   The data of the framebuffer.
+ * ---------------------------------------------------------------- */
+struct Framebuffer::Data
+{
+    // Constructs the framebuffer data
+    Data(int width, int height, int samples)
+        : width(width)
+        , height(height)
+        , samples(samples)
+    { createFramebuffer(); }
+
+    // Destroys the framebuffer data
+    ~Data()
+    { destroyFramebuffer(); }
+
+    // Creates the framebuffer with RGBA8 color and 24-bit depth
+    // renderbuffer. A single sampled color is a texture that is
+    // sampled with linear filtering and clamped into edges, a multi-
+    // sampled color is a renderbuffer.
+    void createFramebuffer()
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        Trace& trace = Trace::instance();
+
+        // -----------------------------------------------------------
+        // Create the color texture or multisampled renderbuffer.
+
+        if (samples > 0)
+        {
+            colorRenderbuffer =
+                registry.createRenderbuffer("Framebuffer color");
+            trace.bindRenderbuffer(colorRenderbuffer);
+            registry.renderbufferStorage(colorRenderbuffer, samples,
+                                         GL_RGBA8, width, height);
+            trace.bindRenderbuffer(0);
+        }
+        else
+        {
+            color = registry.createTexture("Framebuffer color");
+            trace.bindTexture(GL_TEXTURE_2D, color);
+            registry.textureImage2D(color, GL_RGBA8, width, height,
+                                    GL_RGBA, GL_UNSIGNED_BYTE, 0);
+            trace.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                                GL_LINEAR);
+            trace.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
+                                GL_LINEAR);
+            trace.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+                                GL_CLAMP_TO_EDGE);
+            trace.texParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+                                GL_CLAMP_TO_EDGE);
+            trace.bindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        // -----------------------------------------------------------
+        // Create the depth renderbuffer.
+
+        depth = registry.createRenderbuffer("Framebuffer depth");
+        trace.bindRenderbuffer(depth);
+        registry.renderbufferStorage(depth, samples,
+                                     GL_DEPTH_COMPONENT24,
+                                     width, height);
+        trace.bindRenderbuffer(0);
+
+        // -----------------------------------------------------------
+        // Create the framebuffer and attach the color and depth.
+
+        fbo = registry.createFramebuffer("Framebuffer");
+        trace.bindFramebuffer(GL_FRAMEBUFFER, fbo);
+        if (samples > 0)
+            trace.framebufferRenderbuffer(GL_FRAMEBUFFER,
+                                          GL_COLOR_ATTACHMENT0,
+                                          GL_RENDERBUFFER,
+                                          colorRenderbuffer);
+        else
+            trace.framebufferTexture2D(GL_FRAMEBUFFER,
+                                       GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, color, 0);
+        trace.framebufferRenderbuffer(GL_FRAMEBUFFER,
+                                      GL_DEPTH_ATTACHMENT,
+                                      GL_RENDERBUFFER, depth);
+
+        Debug::verifyFramebuffer("Framebuffer");
+
+        trace.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Destroys the framebuffer. OpenGL resources are freed.
+    void destroyFramebuffer()
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        registry.deleteFramebuffer(fbo);
+        registry.deleteRenderbuffer(depth);
+        registry.deleteTexture(color);
+        registry.deleteRenderbuffer(colorRenderbuffer);
+        fbo = depth = color = colorRenderbuffer = 0;
+    }
+
+    int width   = 0; // width of the framebuffer
+    int height  = 0; // height of the framebuffer
+    int samples = 0; // sample count, zero if not multisampled
+
+    GLuint fbo   = 0; // framebuffer object name
+    GLuint color = 0; // color texture name
+    GLuint colorRenderbuffer = 0; // multisampled color name
+    GLuint depth = 0; // depth renderbuffer name
+};
+
+/* ---------------------------------------------------------------- *
+   Constructs the framebuffer from the width and height dimensions.
+ * -----------------------------------------------------------------*/
+Framebuffer::Framebuffer(int width, int height, int samples)
+    : d(std::make_shared<Data>(width, height, samples))
+{}
+
+/* ---------------------------------------------------------------- *
+   Resizes the framebuffer. The attachments are re-created only if
+   the size or the sample count has changed.
+ * -----------------------------------------------------------------*/
+void Framebuffer::resize(int width, int height, int samples)
+{
+    if (width   == d->width  &&
+        height  == d->height &&
+        samples == d->samples)
+    {
+        return;
+    }
+
+    d->destroyFramebuffer();
+    d->width   = width;
+    d->height  = height;
+    d->samples = samples;
+    d->createFramebuffer();
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the width of the framebuffer.
+ * -----------------------------------------------------------------*/
+int Framebuffer::width() const
+{ return d->width; }
+
+/* ---------------------------------------------------------------- *
+   Returns the height of the framebuffer.
+ * -----------------------------------------------------------------*/
+int Framebuffer::height() const
+{ return d->height; }
+
+/* ---------------------------------------------------------------- *
+   Returns the sample count.
+ * -----------------------------------------------------------------*/
+int Framebuffer::samples() const
+{ return d->samples; }
+
+/* ---------------------------------------------------------------- *
+   Returns the framebuffer object name.
+ * -----------------------------------------------------------------*/
+GLuint Framebuffer::id() const
+{ return d->fbo; }
+
+/* ---------------------------------------------------------------- *
+   Returns the color texture name.
+ * -----------------------------------------------------------------*/
+GLuint Framebuffer::colorTexture() const
+{ return d->color; }
+
+/* ---------------------------------------------------------------- *
+   Binds the framebuffer as the draw and read framebuffer.
+ * -----------------------------------------------------------------*/
+void Framebuffer::bind()
+{
+    Trace::instance().bindFramebuffer(GL_FRAMEBUFFER, d->fbo);
+}
+
+/* ---------------------------------------------------------------- *
+   Blits the color into the target framebuffer. The blit is a cheap
+   way to scale the framebuffer as the filtering is done by the
+   fixed function hardware. The target is left bound as the draw
+   and read framebuffer.
+ * -----------------------------------------------------------------*/
+void Framebuffer::blit(GLuint target,
+                       int targetWidth,
+                       int targetHeight,
+                       GLenum filter)
+{
+    Trace& trace = Trace::instance();
+    trace.bindFramebuffer(GL_READ_FRAMEBUFFER, d->fbo);
+    trace.bindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+    trace.blitFramebuffer(0, 0, d->width, d->height,
+                          0, 0, targetWidth, targetHeight,
+                          GL_COLOR_BUFFER_BIT, filter);
+    trace.bindFramebuffer(GL_FRAMEBUFFER, target);
+}
+
+} // namespace opengl
+} // namespace kuu
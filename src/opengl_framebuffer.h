@@ -0,0 +1,84 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::Framebuffer class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+#include "opengl.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   An offscreen framebuffer with a color and a depth attachment.
+   The color attachment is a texture so that the result can be
+   sampled or blitted into another framebuffer. If the framebuffer
+   is multisampled then the color attachment is a renderbuffer and
+   it needs to be resolved with a blit into a framebuffer of the
+   same size before it can be sampled. The OpenGL context must be
+   valid when the Framebuffer instance is constructed. If the frame-
+   buffer is not complete then the error is printed into standard
+   error stream.
+
+   Example:
+
+    // Create 360 x 288 framebuffer
+    Framebuffer::Ptr fb = std::make_shared<Framebuffer>(360, 288);
+    ...
+    // render into framebuffer
+    fb->bind();
+    glViewport(0, 0, fb->width(), fb->height());
+    ...
+    // upscale into default framebuffer of 720 x 576
+    fb->blit(0, 720, 576, GL_LINEAR);
+
+ * ---------------------------------------------------------------- */
+class Framebuffer
+{
+public:
+    // Defines a shared pointer of framebuffer.
+    using Ptr = std::shared_ptr<Framebuffer>;
+
+    // Constructs the framebuffer. OpenGL context must be valid.
+    // If the sample count is above zero then the framebuffer is
+    // multisampled.
+    Framebuffer(int width, int height, int samples = 0);
+
+    // Re-creates the attachments if the size or the sample count
+    // has changed.
+    void resize(int width, int height, int samples = 0);
+
+    // Returns the size of the framebuffer.
+    int width() const;
+    int height() const;
+    // Returns the sample count, zero if not multisampled.
+    int samples() const;
+
+    // Returns the framebuffer object name.
+    GLuint id() const;
+    // Returns the color texture name, zero if multisampled.
+    GLuint colorTexture() const;
+
+    // Binds the framebuffer as the draw and read framebuffer.
+    void bind();
+
+    // Blits the color into the target framebuffer. The whole
+    // framebuffer is stretched into the target size. A multisampled
+    // framebuffer can only be blitted with the same size and with
+    // GL_NEAREST filter.
+    void blit(GLuint target,
+              int targetWidth,
+              int targetHeight,
+              GLenum filter);
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,196 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::Fxaa class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_fxaa.h"
+#include <iostream>
+#include <string>
+#include "opengl_debug.h"
+#include "opengl_resource_registry.h"
+#include "opengl_trace.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   The data of the FXAA pass.
+ * ---------------------------------------------------------------- */
+struct Fxaa::Data
+{
+    // Constructs the FXAA data
+    Data()
+    { createFxaa(); }
+
+    // Destroys the FXAA data
+    ~Data()
+    { destroyFxaa(); }
+
+    // Creates the FXAA pass. The pass draws a single triangle that
+    // covers the whole viewport. The triangle vertices are generated
+    // from the vertex ID so the vertex array has no buffers, core
+    // profile still needs a vertex array to be bound.
+    void createFxaa()
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+
+        vao = registry.createVertexArray("FXAA VAO");
+
+        // -----------------------------------------------------------
+        // Create the vertex shader
+
+        const std::string vshSource =
+            "#version 330 core\r\n" // note linebreak
+            "out vec2 texCoord;"
+            "void main(void)"
+            "{"
+                "vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);"
+                "texCoord = p;"
+                "gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);"
+            "}";
+
+        // -----------------------------------------------------------
+        // Create the fragment shader. The luminance of the four
+        // diagonal neighbours gives the edge direction, the color is
+        // then blended from two or four samples along the direction.
+        // If the four sample blend goes out of the local luminance
+        // range then the two sample blend is used.
+
+        const std::string fshSource =
+            "#version 330 core\r\n" // note linebreak
+            "uniform sampler2D image;"
+            "uniform vec2 texelSize;"
+            "in vec2 texCoord;"
+            "out vec4 colorOut;"
+            "const float SpanMax   = 8.0;"
+            "const float ReduceMul = 1.0 / 8.0;"
+            "const float ReduceMin = 1.0 / 128.0;"
+            "const vec3 Luma = vec3(0.299, 0.587, 0.114);"
+            "void main(void)"
+            "{"
+                "vec3 rgbNW = texture(image, texCoord + vec2(-1.0, -1.0) * texelSize).rgb;"
+                "vec3 rgbNE = texture(image, texCoord + vec2( 1.0, -1.0) * texelSize).rgb;"
+                "vec3 rgbSW = texture(image, texCoord + vec2(-1.0,  1.0) * texelSize).rgb;"
+                "vec3 rgbSE = texture(image, texCoord + vec2( 1.0,  1.0) * texelSize).rgb;"
+                "vec3 rgbM  = texture(image, texCoord).rgb;"
+
+                "float lumaNW = dot(rgbNW, Luma);"
+                "float lumaNE = dot(rgbNE, Luma);"
+                "float lumaSW = dot(rgbSW, Luma);"
+                "float lumaSE = dot(rgbSE, Luma);"
+                "float lumaM  = dot(rgbM,  Luma);"
+                "float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));"
+                "float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));"
+
+                "vec2 dir;"
+                "dir.x = -((lumaNW + lumaNE) - (lumaSW + lumaSE));"
+                "dir.y =  ((lumaNW + lumaSW) - (lumaNE + lumaSE));"
+                "float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * ReduceMul), ReduceMin);"
+                "float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);"
+                "dir = clamp(dir * rcpDirMin, vec2(-SpanMax), vec2(SpanMax)) * texelSize;"
+
+                "vec3 rgbA = 0.5 * ("
+                    "texture(image, texCoord + dir * (1.0 / 3.0 - 0.5)).rgb +"
+                    "texture(image, texCoord + dir * (2.0 / 3.0 - 0.5)).rgb);"
+                "vec3 rgbB = rgbA * 0.5 + 0.25 * ("
+                    "texture(image, texCoord + dir * -0.5).rgb +"
+                    "texture(image, texCoord + dir *  0.5).rgb);"
+                "float lumaB = dot(rgbB, Luma);"
+                "if (lumaB < lumaMin || lumaB > lumaMax)"
+                    "colorOut = vec4(rgbA, 1.0);"
+                "else "
+                    "colorOut = vec4(rgbB, 1.0);"
+            "}";
+
+        vsh = compileShader(GL_VERTEX_SHADER, vshSource,
+                            "FXAA vertex shader");
+        fsh = compileShader(GL_FRAGMENT_SHADER, fshSource,
+                            "FXAA fragment shader");
+
+        // -----------------------------------------------------------
+        // Create the OpenGL shader program.
+
+        Trace& trace = Trace::instance();
+        pgm = registry.createProgram("FXAA shader program");
+        trace.attachShader(pgm, vsh);
+        trace.attachShader(pgm, fsh);
+
+        trace.linkProgram(pgm);
+        Debug::verifyLink(pgm, "FXAA shader program");
+
+        imageLocation     = trace.uniformLocation(pgm, "image");
+        texelSizeLocation = trace.uniformLocation(pgm, "texelSize");
+    }
+
+    // Creates and compiles a shader. The compile status is verified
+    // only if KUU_OPENGL_VERIFY is defined.
+    GLuint compileShader(GLenum type,
+                         const std::string& source,
+                         const std::string& label)
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        Trace& trace = Trace::instance();
+        const GLuint shader = registry.createShader(type, label);
+
+        trace.shaderSource(shader, source);
+        trace.compileShader(shader);
+        Debug::verifyCompile(shader, label);
+        return shader;
+    }
+
+    // Destroys the FXAA pass. OpenGL resources are freed.
+    void destroyFxaa()
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        registry.deleteVertexArray(vao);
+        registry.deleteShader(vsh);
+        registry.deleteShader(fsh);
+        registry.deleteProgram(pgm);
+    }
+
+    GLuint vao = 0; // empty vertex array object name
+    GLuint vsh = 0; // vertex shader name
+    GLuint fsh = 0; // fragment shader name
+    GLuint pgm = 0; // shader program name
+
+    GLint imageLocation     = -1; // image sampler uniform location
+    GLint texelSizeLocation = -1; // texel size uniform location
+};
+
+/* ---------------------------------------------------------------- *
+   Constructs the FXAA pass.
+ * -----------------------------------------------------------------*/
+Fxaa::Fxaa()
+    : d(std::make_shared<Data>())
+{}
+
+/* ---------------------------------------------------------------- *
+   Renders the texture with FXAA. The depth test is disabled as the
+   pass covers the whole viewport.
+ * -----------------------------------------------------------------*/
+void Fxaa::render(GLuint texture, int width, int height)
+{
+    Trace& trace = Trace::instance();
+    trace.disable(GL_DEPTH_TEST);
+
+    trace.bindVertexArray(d->vao);
+    trace.useProgram(d->pgm);
+
+    trace.activeTexture(GL_TEXTURE0);
+    trace.bindTexture(GL_TEXTURE_2D, texture);
+    trace.uniform1i(d->imageLocation, 0);
+    trace.uniform2f(d->texelSizeLocation,
+                    1.0f / float(width),
+                    1.0f / float(height));
+
+    trace.drawArrays(GL_TRIANGLES, 0, 3);
+
+    trace.bindTexture(GL_TEXTURE_2D, 0);
+    trace.useProgram(0);
+    trace.bindVertexArray(0);
+}
+
+} // namespace opengl
+} // namespace kuu
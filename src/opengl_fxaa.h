@@ -0,0 +1,57 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::Fxaa class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+#include "opengl.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A single-pass FXAA post-process. The pass samples a color texture
+   and writes the anti-aliased result into the currently bound
+   framebuffer. The edges are found from the luminance contrast and
+   blurred along the edge direction, which is much cheaper than the
+   multisampling as the scene is rendered with a single sample.
+
+   The OpenGL context must be valid when the Fxaa instance is con-
+   structed. If the construction fails then all the errors are
+   printed into standard error stream.
+
+   Example:
+
+    Fxaa::Ptr fxaa = std::make_shared<Fxaa>();
+    ...
+    // render the scene into framebuffer
+    ...
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, viewportWidth, viewportHeight);
+    fxaa->render(fb->colorTexture(), fb->width(), fb->height());
+
+ * ---------------------------------------------------------------- */
+class Fxaa
+{
+public:
+    // Defines a shared pointer of FXAA.
+    using Ptr = std::shared_ptr<Fxaa>;
+
+    // Constructs the FXAA pass. OpenGL context must be valid.
+    Fxaa();
+
+    // Renders the texture of the given size with FXAA into the
+    // currently bound framebuffer.
+    void render(GLuint texture, int width, int height);
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,113 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::GpuTimer class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_gpu_timer.h"
+#include <vector>
+#include "opengl.h"
+#include "opengl_debug.h"
+#include "opengl_resource_registry.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   The data of the GPU timer. The queries are used in a ring; the
+   write index points to the next query to begin and the read index
+   into the oldest query that has not been read yet.
+ * ---------------------------------------------------------------- */
+struct GpuTimer::Data
+{
+    // Count of queries in the ring. This is also the maximum count
+    // of measurements that can be in-flight.
+    static const int QueryCount = 4;
+
+    // Constructs the timer data
+    Data()
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        for (int i = 0; i < QueryCount; ++i)
+            queries.push_back(registry.createQuery("GPU timer"));
+    }
+
+    // Destroys the timer data
+    ~Data()
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        for (GLuint query : queries)
+            registry.deleteQuery(query);
+    }
+
+    std::vector<GLuint> queries; // time elapsed query names
+    int writeIndex = 0;          // index of the next query to begin
+    int readIndex  = 0;          // index of the oldest pending query
+    int pending    = 0;          // count of pending queries
+    bool active    = false;      // true if a query has begun
+};
+
+/* ---------------------------------------------------------------- *
+   Constructs the GPU timer.
+ * -----------------------------------------------------------------*/
+GpuTimer::GpuTimer()
+    : d(std::make_shared<Data>())
+{}
+
+/* ---------------------------------------------------------------- *
+   Begins the measurement. If all the queries are pending then the
+   measurement is skipped rather than waiting for the GPU.
+ * -----------------------------------------------------------------*/
+void GpuTimer::begin()
+{
+    if (d->pending == Data::QueryCount)
+        return;
+
+    glBeginQuery(GL_TIME_ELAPSED, d->queries[d->writeIndex]);
+    Debug::instance().bound(ResourceRegistry::Query,
+                            d->queries[d->writeIndex]);
+    d->active = true;
+}
+
+/* ---------------------------------------------------------------- *
+   Ends the measurement.
+ * -----------------------------------------------------------------*/
+void GpuTimer::end()
+{
+    if (!d->active)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    d->writeIndex = (d->writeIndex + 1) % Data::QueryCount;
+    d->pending++;
+    d->active = false;
+}
+
+/* ---------------------------------------------------------------- *
+   Gets the oldest finished measurement. The availability is asked
+   before the result so the call does not wait for the GPU. Neither
+   read is counted as a sync call as neither of them waits.
+ * -----------------------------------------------------------------*/
+bool GpuTimer::result(double& milliseconds)
+{
+    if (d->pending == 0)
+        return false;
+
+    const GLuint query = d->queries[d->readIndex];
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    milliseconds = double(nanoseconds) / 1.0e6;
+
+    d->readIndex = (d->readIndex + 1) % Data::QueryCount;
+    d->pending--;
+    return true;
+}
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,60 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::GpuTimer class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A GPU timer that measures the time the GPU spent on commands
+   between begin() and end(). The timer uses a ring of time elapsed
+   queries so that reading a result never waits for the GPU: the
+   result of a frame becomes available a few frames later. The
+   OpenGL context must be valid when the GpuTimer instance is con-
+   structed.
+
+   Example:
+
+    GpuTimer::Ptr timer = std::make_shared<GpuTimer>();
+    ...
+    timer->begin();
+    // render
+    timer->end();
+
+    double ms = 0.0;
+    if (timer->result(ms))
+        std::cout << "GPU time: " << ms << " ms" << std::endl;
+
+ * ---------------------------------------------------------------- */
+class GpuTimer
+{
+public:
+    // Defines a shared pointer of GPU timer.
+    using Ptr = std::shared_ptr<GpuTimer>;
+
+    // Constructs the timer. OpenGL context must be valid.
+    GpuTimer();
+
+    // Begins the measurement.
+    void begin();
+    // Ends the measurement.
+    void end();
+
+    // Gets the oldest finished measurement in milliseconds. Returns
+    // false if there is no finished measurement.
+    bool result(double& milliseconds);
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
@@ -4,278 +4,275 @@
  * ---------------------------------------------------------------- */
 
 #include "opengl_quad.h"
-#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/quaternion.hpp>
 #include "opengl.h"
+#include "opengl_debug.h"
+#include "opengl_resource_registry.h"
+#include "opengl_trace.h"
 
 namespace kuu
 {
 namespace opengl
 {
 
-namespace
-{
-
-/* ---------------------------------------------------------------- *
-   Returns the OpenGL shader info log 
- * ---------------------------------------------------------------- */
-std::string shaderInfoLog(GLint id)
-{
-    GLint length = 0;
-    glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-
-    if (length <= 0)
-        return std::string();
-
-    std::string log;
-    log.resize(length + 1);
-    glGetShaderInfoLog(id, length, NULL, (GLchar*)log.c_str());
-
-    log.erase(std::remove(log.begin(), log.end(), '\0'), log.end());
-    return log;
-}
-    
-} // anonymous namespace
-
 /* ---------------------------------------------------------------- *
    The data of the quad.
  * ---------------------------------------------------------------- */
 struct Quad::Data
 {
     // Constructs the quad data
-    Data(float width, float height)
-        : width(width)
-        , height(height)
-    { createQuad(); }
+    Data(const Source& source)
+    { createQuad(source); }
 
     // Destroys the quad data
     ~Data()
     { destroyQuad(); }
 
-    // Creates the quad. This will create a vertex buffer with two
-    // triangles where a single vertex contains position and color.
-    // The vertices and triangle indices are written into OpenGL
-    // buffers. Vertex array is used to store the vertex attribute
-    // information.
-    //
-    // A simple shader is used to transform vertices from model space
-    // into camera clip space. The shading is done with the vertex
-    // colors.
+    // Creates the quad from the prepared source. The vertices and
+    // triangle indices are written into OpenGL buffers. Vertex array
+    // is used to store the vertex attribute information. The shader
+    // program of the source is registered and used if it is linked,
+    // otherwise the shaders are compiled from the prepared sources.
     //
     // If any of the OpenGL functions fails then the failed object
     // is written into standard error stream. One failure leads to
     // rendering to fail.
     //
-    void createQuad()
+    void createQuad(const Source& source)
     {
-        // -----------------------------------------------------------
-        // Create quad vertex data. The center of the quad is at the
-        // origo. The vertex properties are packed where the first
-        // is vertes position and then color components.
-
-        const float w = width  * 0.5f;
-        const float h = height * 0.5f;
-        const std::vector<float> vertexData =
-        {
-          // x   y   z     r     g     b
-            -w, -h, 0.0f, 1.0f, 0.0f, 0.0f,
-             w, -h, 0.0f, 0.0f, 1.0f, 0.0f,
-             w,  h, 0.0f, 0.0f, 0.0f, 1.0f,
-            -w,  h, 0.0f, 1.0f, 1.0f, 0.0f
-        };
-
-        // -----------------------------------------------------------
-        // Create triangle indices (two triangles)
-
-        const std::vector<unsigned int> indexData =
-        {
-            0u, 1u, 2u,
-            2u, 3u, 0u
-        };
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        Trace& trace = Trace::instance();
 
         // -----------------------------------------------------------
         // Create vertex array object and bind it.
 
-        glGenVertexArrays(1, &vao);
-        if (vao == 0)
-            std::cerr << "Failed to generate VAO" << std::endl;
+        vao = registry.createVertexArray("Quad VAO");
 
-        glBindVertexArray(vao);
-        GLint current = 0;
-        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &current);
-        if (current != vao)
-            std::cerr << "Failed to bind VAO" << std::endl;
+        trace.bindVertexArray(vao);
+        Debug::verifyBinding(GL_VERTEX_ARRAY_BINDING, vao, "VAO");
 
         // -----------------------------------------------------------
         // Create the OpenGL vertex buffer object and write the
-        // vertices into it (ID and bind statuses are asserted).
+        // vertices into it (ID and bind statuses are verified).
 
-        glGenBuffers(1, &vbo);
-        if (vbo == 0)
-            std::cerr << "Failed to generate VBO" << std::endl;
+        vbo = registry.createBuffer("Quad VBO");
 
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &current);
-        if (current != vbo)
-            std::cerr << "Failed to bind VBO" << std::endl;
+        trace.bindBuffer(GL_ARRAY_BUFFER, vbo);
+        Debug::verifyBinding(GL_ARRAY_BUFFER_BINDING, vbo, "VBO");
 
-        glBufferData(GL_ARRAY_BUFFER,
-                     vertexData.size() * sizeof(float),
-                     &vertexData[0],
-                     GL_STATIC_DRAW);
+        registry.bufferData(vbo, GL_ARRAY_BUFFER,
+                            source.vertexData.size() * sizeof(float),
+                            &source.vertexData[0],
+                            GL_STATIC_DRAW);
 
         // -----------------------------------------------------------
         // Create index buffer object and writes the indices into it.
 
-        glGenBuffers(1, &ibo);
-        if (ibo == 0)
-            std::cerr << "Failed to generate IBO" << std::endl;
+        ibo = registry.createBuffer("Quad IBO");
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &current);
-        if (current != ibo)
-            std::cerr << "Failed to bind IBO" << std::endl;
+        trace.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        Debug::verifyBinding(GL_ELEMENT_ARRAY_BUFFER_BINDING, ibo,
+                             "IBO");
 
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                     indexData.size() * sizeof(unsigned int),
-                     &indexData[0],
-                     GL_STATIC_DRAW);
+        registry.bufferData(ibo, GL_ELEMENT_ARRAY_BUFFER,
+                            source.indexData.size() *
+                            sizeof(unsigned int),
+                            &source.indexData[0],
+                            GL_STATIC_DRAW);
 
         // -----------------------------------------------------------
         // Define vertex attributes (position and color)
 
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(
+        trace.enableVertexAttribArray(0);
+        trace.vertexAttribPointer(
             0, 3, GL_FLOAT, GL_FALSE,
-            6 * sizeof(float), (const GLvoid*) 0);
+            6 * sizeof(float), 0);
 
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(
+        trace.enableVertexAttribArray(1);
+        trace.vertexAttribPointer(
             1, 3, GL_FLOAT, GL_FALSE,
             6 * sizeof(float),
-            (const GLvoid*) (3 * sizeof(float)));
+            3 * sizeof(float));
 
         // Release (notice order)
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        trace.bindVertexArray(0);
+        trace.bindBuffer(GL_ARRAY_BUFFER, 0);
+        trace.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
         // -----------------------------------------------------------
-        // Create the vertex shader
-
-        const std::string vshSource =
-            "#version 330 core\r\n" // note linebreak
-            "layout (location = 0) in vec3 position;"
-            "layout (location = 1) in vec3 color;"
-            "uniform mat4 cameraMatrix;"
-            "out vec4 colorIn;"
-            "void main(void)"
-            "{"
-               " gl_Position = cameraMatrix * vec4(position, 1.0);"
-                "colorIn = vec4(color, 1.0);"
-            "}";
-
-        vsh = glCreateShader(GL_VERTEX_SHADER);
-        if (vsh == 0)
-            std::cerr << "Failed to create vertex shader"
-                      << std::endl;
-
-        const char* vshPtr = vshSource.c_str();
-        glShaderSource(vsh, 1, &vshPtr, 0);
+        // Use the linked shader program or link it now.
 
-        glCompileShader(vsh);
-        GLint status = 0;
-        glGetShaderiv(vsh, GL_COMPILE_STATUS, &status);
-        if (status != GL_TRUE)
-        {
-            std::cerr << "Failed to compile vertex shader"
-                      << std::endl;
-            std::cerr << shaderInfoLog(vsh) << std::endl;
-        }
+        pgm = source.program;
+        if (pgm != 0)
+            registry.adoptProgram(pgm, "Quad shader program");
+        else
+            pgm = linkProgram(source);
 
         // -----------------------------------------------------------
-        // Create the fragment shader.
-
-        const std::string fshSource =
-            "#version 330 core\r\n" // note linebreak
-            "in vec4 colorIn;"
-            "out vec4 colorOut;"
-            "void main(void)"
-            "{"
-                "colorOut = colorIn;"
-            "}";
-
-        fsh = glCreateShader(GL_FRAGMENT_SHADER);
-        if (fsh == 0)
-        {
-            std::cerr << "Failed to create fragment shader"
-                      << std::endl;
-            std::cerr << shaderInfoLog(fsh) << std::endl;
-        }
-
-        const char* fshPtr = fshSource.c_str();
-        glShaderSource(fsh, 1, &fshPtr, 0);
+        // Find the camera matrix uniform location. The location is
+        // looked once here instead of every draw.
 
-        glCompileShader(fsh);
-        glGetShaderiv(fsh, GL_COMPILE_STATUS, &status);
-        if (status != GL_TRUE)
-            std::cerr << "Failed to compile fragment shader"
-                      << std::endl;
-
-        // -----------------------------------------------------------
-        // Create the OpenGL shader program.
-
-        pgm = glCreateProgram();
-        if (pgm == 0)
-            std::cerr << "Failed to create shader program"
-                      << std::endl;
-
-        glAttachShader(pgm, vsh);
-        glAttachShader(pgm, fsh);
-
-        glLinkProgram(pgm);
-        glGetProgramiv(pgm, GL_LINK_STATUS, &status);
-        if (status != GL_TRUE)
-            std::cerr << "Failed to ling shader program"
+        cameraMatrixLocation =
+            trace.uniformLocation(pgm, "cameraMatrix");
+        if (cameraMatrixLocation == -1)
+            std::cerr << "Failed to find cameraMatrix uniform location."
                       << std::endl;
     }
 
     // Destroys the quad. OpenGL resources are freed.
     void destroyQuad()
     {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+
         // Destroy vertex and index buffers
-        glDeleteBuffers(1, &ibo);
-        glDeleteBuffers(1, &vbo);
+        registry.deleteBuffer(ibo);
+        registry.deleteBuffer(vbo);
         // Destroy vertex array
-        glDeleteVertexArrays(1, &vao);
-        // Destroy shader
-        glDeleteShader(vsh);
-        glDeleteShader(fsh);
-        glDeleteProgram(pgm);
+        registry.deleteVertexArray(vao);
+        // Destroy shader program
+        registry.deleteProgram(pgm);
     }
 
-    float width  = 1.0f; // width of the quad
-    float height = 1.0f; // height of the quad
-
     GLuint vbo = 0; // vertex buffer object name
     GLuint ibo = 0; // index buffer object name
     GLuint vao = 0; // vertex array object name
-    GLuint vsh = 0; // vertex shader name
-    GLuint fsh = 0; // fragment shader name
     GLuint pgm = 0; // shader program name
 
+    GLint cameraMatrixLocation = -1; // camera matrix uniform location
+
     glm::quat yaw; // rotation around y-axis
 };
 
+/* ---------------------------------------------------------------- *
+   Prepares the source of the quad. The center of the quad is at
+   the origo. OpenGL is not used so this can be called from any
+   thread.
+ * -----------------------------------------------------------------*/
+Quad::Source Quad::prepare(float width, float height)
+{
+    Source source;
+
+    // ---------------------------------------------------------------
+    // Create quad vertex data. The center of the quad is at the
+    // origo. The vertex properties are packed where the first
+    // is vertes position and then color components.
+
+    const float w = width  * 0.5f;
+    const float h = height * 0.5f;
+    source.vertexData =
+    {
+      // x   y   z     r     g     b
+        -w, -h, 0.0f, 1.0f, 0.0f, 0.0f,
+         w, -h, 0.0f, 0.0f, 1.0f, 0.0f,
+         w,  h, 0.0f, 0.0f, 0.0f, 1.0f,
+        -w,  h, 0.0f, 1.0f, 1.0f, 0.0f
+    };
+
+    // ---------------------------------------------------------------
+    // Create triangle indices (two triangles)
+
+    source.indexData =
+    {
+        0u, 1u, 2u,
+        2u, 3u, 0u
+    };
+
+    // ---------------------------------------------------------------
+    // Vertex shader transforms the vertices into camera clip space.
+
+    source.vertexShader =
+        "#version 330 core\r\n" // note linebreak
+        "layout (location = 0) in vec3 position;"
+        "layout (location = 1) in vec3 color;"
+        "uniform mat4 cameraMatrix;"
+        "out vec4 colorIn;"
+        "void main(void)"
+        "{"
+           " gl_Position = cameraMatrix * vec4(position, 1.0);"
+            "colorIn = vec4(color, 1.0);"
+        "}";
+
+    // ---------------------------------------------------------------
+    // Fragment shader shades with the vertex colors.
+
+    source.fragmentShader =
+        "#version 330 core\r\n" // note linebreak
+        "in vec4 colorIn;"
+        "out vec4 colorOut;"
+        "void main(void)"
+        "{"
+            "colorOut = colorIn;"
+        "}";
+
+    return source;
+}
+
+/* ---------------------------------------------------------------- *
+   Compiles the shaders of the source and links the shader program.
+   The shaders are deleted after the link, the program keeps them
+   alive while they are attached.
+ * -----------------------------------------------------------------*/
+GLuint Quad::linkProgram(const Source& source)
+{
+    ResourceRegistry& registry = ResourceRegistry::instance();
+    Trace& trace = Trace::instance();
+
+    // ---------------------------------------------------------------
+    // Create the vertex shader
+
+    const GLuint vsh = registry.createShader(GL_VERTEX_SHADER,
+                                             "Quad vertex shader");
+
+    trace.shaderSource(vsh, source.vertexShader);
+
+    trace.compileShader(vsh);
+    Debug::verifyCompile(vsh, "vertex shader");
+
+    // ---------------------------------------------------------------
+    // Create the fragment shader.
+
+    const GLuint fsh = registry.createShader(GL_FRAGMENT_SHADER,
+                                             "Quad fragment shader");
+
+    trace.shaderSource(fsh, source.fragmentShader);
+
+    trace.compileShader(fsh);
+    Debug::verifyCompile(fsh, "fragment shader");
+
+    // ---------------------------------------------------------------
+    // Create the OpenGL shader program.
+
+    const GLuint pgm = registry.createProgram("Quad shader program");
+
+    trace.attachShader(pgm, vsh);
+    trace.attachShader(pgm, fsh);
+
+    trace.linkProgram(pgm);
+    Debug::verifyLink(pgm, "shader program");
+
+    // The shaders are flagged for deletion and freed with the program.
+    registry.deleteShader(vsh);
+    registry.deleteShader(fsh);
+
+    return pgm;
+}
+
 /* ---------------------------------------------------------------- *
    Constructs the quad from the width and height dimensions.
  * -----------------------------------------------------------------*/
 Quad::Quad(float width, float height)
-    : d(std::make_shared<Data>(width, height))
+    : d(std::make_shared<Data>(prepare(width, height)))
+{}
+
+/* ---------------------------------------------------------------- *
+   Constructs the quad from the prepared source.
+ * -----------------------------------------------------------------*/
+Quad::Quad(const Source& source)
+    : d(std::make_shared<Data>(source))
 {}
 
 /* ---------------------------------------------------------------- *
@@ -298,41 +295,57 @@ void Quad::update(float elapsed)
 void Quad::render(const glm::mat4& view,
                   const glm::mat4& projection)
 {
+    // Creates the transform from model space into world space
+    glm::mat4 model;
+    model = glm::mat4_cast(d->yaw);
+
+    bind();
+    draw(projection * view * model);
+    release();
+}
+
+/* ---------------------------------------------------------------- *
+   Binds the vertex array and the shader program.
+ * -----------------------------------------------------------------*/
+void Quad::bind()
+{
+    Trace& trace = Trace::instance();
+
     // Bind the buffers.
-    glBindVertexArray(d->vao);
+    trace.bindVertexArray(d->vao);
 
     // Bind and validate the shader program.
-    glUseProgram(d->pgm);
+    trace.useProgram(d->pgm);
+    Debug::verifyProgram(d->pgm);
+}
 
-    glValidateProgram(d->pgm);
-    GLint status = 0;
-    glGetProgramiv(d->pgm, GL_VALIDATE_STATUS, &status);
-    if (status != GL_TRUE)
-        std::cout << "Shader program is not valid" << std::endl;
+/* ---------------------------------------------------------------- *
+   Draws the bound quad. The camera matrix transforms the vertices
+   from model space into camera clipping space.
+ * -----------------------------------------------------------------*/
+void Quad::draw(const glm::mat4& camera)
+{
+    if (d->cameraMatrixLocation == -1)
+        return;
 
-    // Creates the transform from model space into world space
-    glm::mat4 model;
-    model = glm::mat4_cast(d->yaw);
+    Trace& trace = Trace::instance();
 
     // Set the camera matrix
-    const glm::mat4 camera = projection * view * model;
-    const int uniformLocation =
-        glGetUniformLocation(d->pgm, "cameraMatrix");
-    if (uniformLocation == -1)
-    {
-        std::cerr << "Failed to find cameraMatrix uniform location."
-                  << std::endl;
-        return;
-    }
-    glUniformMatrix4fv(uniformLocation, 1, GL_FALSE,
-                       glm::value_ptr(camera));
+    trace.uniformMatrix4fv(d->cameraMatrixLocation,
+                           glm::value_ptr(camera));
 
     // Draw the two triangles
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    trace.drawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+}
 
-    // Release the binded state
-    glUseProgram(0);
-    glBindVertexArray(0);
+/* ---------------------------------------------------------------- *
+   Releases the binded state.
+ * -----------------------------------------------------------------*/
+void Quad::release()
+{
+    Trace& trace = Trace::instance();
+    trace.useProgram(0);
+    trace.bindVertexArray(0);
 }
 
 } // namespace opengl
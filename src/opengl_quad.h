@@ -6,6 +6,8 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 #include <glm/mat4x4.hpp>
 
 namespace kuu
@@ -22,6 +24,13 @@ namespace opengl
    struction fails then all the errors are printed into standard er-
    ror stream.
 
+   The vertices, indices and shader sources can be prepared without
+   OpenGL, e.g. on a worker thread, and the quad constructed from
+   them later when the context is current. The shader program can
+   be linked beforehand in a context that shares the objects with
+   the rendering context, then the quad registers the program, takes
+   its ownership and does not compile the shaders.
+
    Example:
 
     // Create quad
@@ -35,6 +44,22 @@ namespace opengl
     glm::mat4 cameraProjectionMatrix = getCameraProjectionMatrix();
     quad.render(cameraViewMatrix, cameraProjectionMatrix);
 
+   The quad can also be used as a mesh that is drawn many times with
+   the given transforms. The bind is done once for all the draws.
+
+    quad.bind();
+    for (const glm::mat4& model : models)
+        quad.draw(cameraProjectionMatrix * cameraViewMatrix * model);
+    quad.release();
+
+   Prepare the source on a worker thread:
+
+    std::future<Quad::Source> source =
+        std::async(std::launch::async, &Quad::prepare, 3.0f, 4.0f);
+    ...
+    // context is current
+    Quad::Ptr quad = std::make_shared<Quad>(source.get());
+
  * ---------------------------------------------------------------- */
 class Quad
 {
@@ -42,8 +67,28 @@ public:
     // Defines a shared pointer of quad.
     using Ptr = std::shared_ptr<Quad>;
 
+    // The data of the quad that does not need OpenGL.
+    struct Source
+    {
+        std::vector<float> vertexData;       // position and color
+        std::vector<unsigned int> indexData; // triangle indices
+        std::string vertexShader;            // vertex shader GLSL
+        std::string fragmentShader;          // fragment shader GLSL
+        unsigned int program = 0;            // unregistered program
+    };
+
+    // Prepares the source of the quad. Can be called from any thread.
+    static Source prepare(float width = 1.0f, float height = 1.0f);
+    // Compiles the shaders of the source and links them into a shader
+    // program through the resource registry. The shader objects are
+    // deleted after the link. OpenGL context must be valid.
+    static unsigned int linkProgram(const Source& source);
+
     // Constructs the quad. OpenGL context must be valid.
     Quad(float width = 1.0f, float height = 1.0f);
+    // Constructs the quad from the prepared source. OpenGL context
+    // must be valid.
+    Quad(const Source& source);
 
     // Updates the quad rotation.
     void update(float elapsed);
@@ -52,6 +97,13 @@ public:
     void render(const glm::mat4& view,
                 const glm::mat4& projection);
 
+    // Binds the quad mesh and shader program for drawing.
+    void bind();
+    // Draws the bound quad with the model-view-projection matrix.
+    void draw(const glm::mat4& camera);
+    // Releases the bind.
+    void release();
+
 private:
     struct Data;
     std::shared_ptr<Data> d;
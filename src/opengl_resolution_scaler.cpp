@@ -0,0 +1,126 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::ResolutionScaler class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_resolution_scaler.h"
+#include <algorithm>
+#include <vector>
+
+namespace kuu
+{
+namespace opengl
+{
+
+namespace
+{
+
+const double MinScale      = 0.5;  // smallest resolution scale
+const double MaxScale      = 1.0;  // largest resolution scale
+const double DecreaseRatio = 0.9;  // scale multiplier when over
+const double IncreaseStep  = 0.05; // scale increment when under
+const double Headroom      = 0.85; // budget ratio to increase scale
+const int OverFrameCount   = 4;    // frames over budget to decrease
+const int UnderFrameCount  = 30;   // frames under headroom to increase
+const int HistoryCount     = 120;  // frames in hit-rate history
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   The data of the scaler.
+ * ---------------------------------------------------------------- */
+struct ResolutionScaler::Data
+{
+    // Constructs the scaler data
+    Data(double targetFrameTime)
+        : targetFrameTime(targetFrameTime)
+        , history(HistoryCount, true)
+    {}
+
+    double targetFrameTime;    // budget in milliseconds
+    double scale = MaxScale;   // current resolution scale
+    int overCount  = 0;        // successive frames over budget
+    int underCount = 0;        // successive frames under headroom
+
+    std::vector<bool> history; // budget hits of the recent frames
+    int historyIndex = 0;      // index of the next history entry
+    int hitCount = HistoryCount; // count of hits in history
+};
+
+/* ---------------------------------------------------------------- *
+   Constructs the scaler.
+ * -----------------------------------------------------------------*/
+ResolutionScaler::ResolutionScaler(double targetFrameTime)
+    : d(std::make_shared<Data>(targetFrameTime))
+{}
+
+/* ---------------------------------------------------------------- *
+   Sets the target frame time.
+ * -----------------------------------------------------------------*/
+void ResolutionScaler::setTargetFrameTime(double targetFrameTime)
+{ d->targetFrameTime = targetFrameTime; }
+
+/* ---------------------------------------------------------------- *
+   Returns the target frame time.
+ * -----------------------------------------------------------------*/
+double ResolutionScaler::targetFrameTime() const
+{ return d->targetFrameTime; }
+
+/* ---------------------------------------------------------------- *
+   Updates the scale. The counters of the successive frames over
+   and under the limits are reset after each scale change so that
+   the next change is based on frames rendered with the new scale.
+ * -----------------------------------------------------------------*/
+void ResolutionScaler::update(double frameTime)
+{
+    // Update the hit-rate history.
+    const bool hit = frameTime <= d->targetFrameTime;
+    if (d->history[d->historyIndex] != hit)
+        d->hitCount += hit ? 1 : -1;
+    d->history[d->historyIndex] = hit;
+    d->historyIndex = (d->historyIndex + 1) % HistoryCount;
+
+    // Count the successive frames over and under the limits.
+    if (!hit)
+    {
+        d->overCount++;
+        d->underCount = 0;
+    }
+    else if (frameTime < d->targetFrameTime * Headroom)
+    {
+        d->underCount++;
+        d->overCount = 0;
+    }
+    else
+    {
+        d->overCount  = 0;
+        d->underCount = 0;
+    }
+
+    // Adjust the scale.
+    if (d->overCount >= OverFrameCount)
+    {
+        d->scale = std::max(MinScale, d->scale * DecreaseRatio);
+        d->overCount = 0;
+    }
+    else if (d->underCount >= UnderFrameCount)
+    {
+        d->scale = std::min(MaxScale, d->scale + IncreaseStep);
+        d->underCount = 0;
+    }
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the current resolution scale.
+ * -----------------------------------------------------------------*/
+double ResolutionScaler::scale() const
+{ return d->scale; }
+
+/* ---------------------------------------------------------------- *
+   Returns the budget hit-rate of the recent frames.
+ * -----------------------------------------------------------------*/
+double ResolutionScaler::budgetHitRate() const
+{ return double(d->hitCount) / HistoryCount; }
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,63 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::ResolutionScaler class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A controller of the rendering resolution. The controller is fed
+   with the measured frame time and it adjusts the resolution scale
+   so that the frames fit into the target frame time (the budget).
+
+   The scale is decreased when the frames have been over the budget
+   and increased when the frames have been clearly under it. The
+   gap between the two limits and the required count of successive
+   frames give the hysteresis so that the scale does not oscillate
+   between two values.
+
+   Example:
+
+    // Target into 60 fps
+    ResolutionScaler scaler(16.6);
+    ...
+    scaler.update(measuredFrameTime);
+    const int w = int(viewportWidth  * scaler.scale());
+    const int h = int(viewportHeight * scaler.scale());
+
+ * ---------------------------------------------------------------- */
+class ResolutionScaler
+{
+public:
+    // Constructs the scaler from target frame time in milliseconds.
+    ResolutionScaler(double targetFrameTime = 16.6);
+
+    // Sets the target frame time in milliseconds.
+    void setTargetFrameTime(double targetFrameTime);
+    // Returns the target frame time in milliseconds.
+    double targetFrameTime() const;
+
+    // Updates the scale from the measured frame time.
+    void update(double frameTime);
+
+    // Returns the current resolution scale, from 0.5 to 1.0.
+    double scale() const;
+
+    // Returns the ratio of the recent frames that fit into the
+    // budget, from 0.0 to 1.0.
+    double budgetHitRate() const;
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
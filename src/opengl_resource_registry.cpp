@@ -0,0 +1,407 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::ResourceRegistry class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_resource_registry.h"
+#include <algorithm>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include "opengl_debug.h"
+#include "opengl_trace.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+namespace
+{
+
+/* ---------------------------------------------------------------- *
+   Returns the size of a single pixel of the internal format in
+   bytes. The size is an estimation as the driver is free to pad
+   the formats, e.g. 24-bit depth is counted as 32 bits.
+ * ---------------------------------------------------------------- */
+long long bytesPerPixel(GLenum internalFormat)
+{
+    switch (internalFormat)
+    {
+        case GL_R8:                 return 1;
+        case GL_RG8:                return 2;
+        case GL_RGB8:               return 3;
+        case GL_RGBA8:              return 4;
+        case GL_SRGB8_ALPHA8:       return 4;
+        case GL_RGBA16F:            return 8;
+        case GL_RGBA32F:            return 16;
+        case GL_DEPTH_COMPONENT16:  return 2;
+        case GL_DEPTH_COMPONENT24:  return 4;
+        case GL_DEPTH_COMPONENT32F: return 4;
+        case GL_DEPTH24_STENCIL8:   return 4;
+        default:                    return 4;
+    }
+}
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   The data of the registry. The live objects are mapped by their
+   category and name.
+ * ---------------------------------------------------------------- */
+struct ResourceRegistry::Data
+{
+    // A live object.
+    struct Object
+    {
+        std::string label;   // label given in creation
+        long long bytes = 0; // memory of the data store
+    };
+
+    // Key of a live object.
+    using Key = std::pair<int, GLuint>;
+
+    // Adds a created object.
+    void add(Category category, GLuint name, const std::string& label)
+    {
+        if (name == 0)
+        {
+            std::cerr << "Failed to create " << categoryName(category)
+                      << " " << label << std::endl;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        Object object;
+        object.label = label;
+        objects[Key(category, name)] = object;
+
+        for (CategoryStatistics* c : { &stats.categories[category],
+                                       &stats.total })
+        {
+            c->count++;
+            c->created++;
+            c->peakCount = std::max(c->peakCount, c->count);
+        }
+    }
+
+    // Sets the memory of the object. The old data store is freed.
+    void setBytes(Category category, GLuint name, long long bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.find(Key(category, name));
+        if (it == objects.end())
+            return;
+
+        for (CategoryStatistics* c : { &stats.categories[category],
+                                       &stats.total })
+        {
+            c->bytes += bytes - it->second.bytes;
+            c->allocated += bytes;
+            c->peakBytes = std::max(c->peakBytes, c->bytes);
+        }
+        it->second.bytes = bytes;
+    }
+
+    // Removes a deleted object.
+    void remove(Category category, GLuint name)
+    {
+        if (name == 0)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.find(Key(category, name));
+        if (it == objects.end())
+        {
+            std::cerr << "Deleting unknown " << categoryName(category)
+                      << " " << name << std::endl;
+            return;
+        }
+
+        for (CategoryStatistics* c : { &stats.categories[category],
+                                       &stats.total })
+        {
+            c->count--;
+            c->deleted++;
+            c->bytes -= it->second.bytes;
+        }
+        objects.erase(it);
+    }
+
+    mutable std::mutex mutex;     // guards the objects and stats
+    std::map<Key, Object> objects; // live objects
+    Statistics stats;              // statistics
+};
+
+/* ---------------------------------------------------------------- *
+   Returns the registry of the process.
+ * ---------------------------------------------------------------- */
+ResourceRegistry& ResourceRegistry::instance()
+{
+    static ResourceRegistry registry;
+    return registry;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the name of the category.
+ * ---------------------------------------------------------------- */
+const char* ResourceRegistry::categoryName(Category category)
+{
+    switch (category)
+    {
+        case Buffer:       return "buffer";
+        case VertexArray:  return "vertex array";
+        case Texture:      return "texture";
+        case Renderbuffer: return "renderbuffer";
+        case Framebuffer:  return "framebuffer";
+        case Shader:       return "shader";
+        case Program:      return "program";
+        case Query:        return "query";
+        default:           return "unknown";
+    }
+}
+
+/* ---------------------------------------------------------------- *
+   Constructs the registry.
+ * ---------------------------------------------------------------- */
+ResourceRegistry::ResourceRegistry()
+    : d(std::make_shared<Data>())
+{}
+
+/* ---------------------------------------------------------------- *
+   Buffers.
+ * ---------------------------------------------------------------- */
+GLuint ResourceRegistry::createBuffer(const std::string& label)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    d->add(Buffer, buffer, label);
+    Trace::instance().recordCreate(Buffer, buffer, 0, label);
+    Debug::instance().setLabel(Buffer, buffer, label);
+    return buffer;
+}
+
+void ResourceRegistry::bufferData(GLuint buffer, GLenum target,
+                                  GLsizeiptr size, const void* data,
+                                  GLenum usage)
+{
+    Trace::instance().bufferData(buffer, target, size, data, usage);
+    d->setBytes(Buffer, buffer, size);
+}
+
+void ResourceRegistry::deleteBuffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
+    d->remove(Buffer, buffer);
+    Trace::instance().recordDelete(Buffer, buffer);
+    Debug::instance().removeLabel(Buffer, buffer);
+}
+
+/* ---------------------------------------------------------------- *
+   Vertex arrays.
+ * ---------------------------------------------------------------- */
+GLuint ResourceRegistry::createVertexArray(const std::string& label)
+{
+    GLuint vertexArray = 0;
+    glGenVertexArrays(1, &vertexArray);
+    d->add(VertexArray, vertexArray, label);
+    Trace::instance().recordCreate(VertexArray, vertexArray, 0, label);
+    Debug::instance().setLabel(VertexArray, vertexArray, label);
+    return vertexArray;
+}
+
+void ResourceRegistry::deleteVertexArray(GLuint vertexArray)
+{
+    glDeleteVertexArrays(1, &vertexArray);
+    d->remove(VertexArray, vertexArray);
+    Trace::instance().recordDelete(VertexArray, vertexArray);
+    Debug::instance().removeLabel(VertexArray, vertexArray);
+}
+
+/* ---------------------------------------------------------------- *
+   Textures. The memory of the base level is tracked.
+ * ---------------------------------------------------------------- */
+GLuint ResourceRegistry::createTexture(const std::string& label)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    d->add(Texture, texture, label);
+    Trace::instance().recordCreate(Texture, texture, 0, label);
+    Debug::instance().setLabel(Texture, texture, label);
+    return texture;
+}
+
+void ResourceRegistry::textureImage2D(GLuint texture,
+                                      GLint internalFormat,
+                                      GLsizei width, GLsizei height,
+                                      GLenum format, GLenum type,
+                                      const void* data)
+{
+    Trace::instance().texImage2D(texture, internalFormat,
+                                 width, height, format, type, data);
+    d->setBytes(Texture, texture,
+                bytesPerPixel(internalFormat) * width * height);
+}
+
+void ResourceRegistry::deleteTexture(GLuint texture)
+{
+    glDeleteTextures(1, &texture);
+    d->remove(Texture, texture);
+    Trace::instance().recordDelete(Texture, texture);
+    Debug::instance().removeLabel(Texture, texture);
+}
+
+/* ---------------------------------------------------------------- *
+   Renderbuffers. A multisampled storage is counted once per sample.
+ * ---------------------------------------------------------------- */
+GLuint ResourceRegistry::createRenderbuffer(const std::string& label)
+{
+    GLuint renderbuffer = 0;
+    glGenRenderbuffers(1, &renderbuffer);
+    d->add(Renderbuffer, renderbuffer, label);
+    Trace::instance().recordCreate(Renderbuffer, renderbuffer, 0, label);
+    Debug::instance().setLabel(Renderbuffer, renderbuffer, label);
+    return renderbuffer;
+}
+
+void ResourceRegistry::renderbufferStorage(GLuint renderbuffer,
+                                           GLsizei samples,
+                                           GLenum internalFormat,
+                                           GLsizei width,
+                                           GLsizei height)
+{
+    Trace::instance().renderbufferStorage(renderbuffer, samples,
+                                          internalFormat,
+                                          width, height);
+
+    d->setBytes(Renderbuffer, renderbuffer,
+                bytesPerPixel(internalFormat) * width * height *
+                std::max(samples, 1));
+}
+
+void ResourceRegistry::deleteRenderbuffer(GLuint renderbuffer)
+{
+    glDeleteRenderbuffers(1, &renderbuffer);
+    d->remove(Renderbuffer, renderbuffer);
+    Trace::instance().recordDelete(Renderbuffer, renderbuffer);
+    Debug::instance().removeLabel(Renderbuffer, renderbuffer);
+}
+
+/* ---------------------------------------------------------------- *
+   Framebuffers.
+ * ---------------------------------------------------------------- */
+GLuint ResourceRegistry::createFramebuffer(const std::string& label)
+{
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    d->add(Framebuffer, framebuffer, label);
+    Trace::instance().recordCreate(Framebuffer, framebuffer, 0, label);
+    Debug::instance().setLabel(Framebuffer, framebuffer, label);
+    return framebuffer;
+}
+
+void ResourceRegistry::deleteFramebuffer(GLuint framebuffer)
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    d->remove(Framebuffer, framebuffer);
+    Trace::instance().recordDelete(Framebuffer, framebuffer);
+    Debug::instance().removeLabel(Framebuffer, framebuffer);
+}
+
+/* ---------------------------------------------------------------- *
+   Shaders and programs.
+ * ---------------------------------------------------------------- */
+GLuint ResourceRegistry::createShader(GLenum type,
+                                      const std::string& label)
+{
+    const GLuint shader = glCreateShader(type);
+    d->add(Shader, shader, label);
+    Trace::instance().recordCreate(Shader, shader, type, label);
+    Debug::instance().setLabel(Shader, shader, label);
+    return shader;
+}
+
+void ResourceRegistry::deleteShader(GLuint shader)
+{
+    glDeleteShader(shader);
+    d->remove(Shader, shader);
+    Trace::instance().recordDelete(Shader, shader);
+    Debug::instance().removeLabel(Shader, shader);
+}
+
+GLuint ResourceRegistry::createProgram(const std::string& label)
+{
+    const GLuint program = glCreateProgram();
+    d->add(Program, program, label);
+    Trace::instance().recordCreate(Program, program, 0, label);
+    Debug::instance().setLabel(Program, program, label);
+    return program;
+}
+
+void ResourceRegistry::adoptProgram(GLuint program,
+                                    const std::string& label)
+{
+    d->add(Program, program, label);
+    Debug::instance().setLabel(Program, program, label);
+}
+
+void ResourceRegistry::deleteProgram(GLuint program)
+{
+    glDeleteProgram(program);
+    d->remove(Program, program);
+    Trace::instance().recordDelete(Program, program);
+    Debug::instance().removeLabel(Program, program);
+}
+
+/* ---------------------------------------------------------------- *
+   Queries.
+ * ---------------------------------------------------------------- */
+GLuint ResourceRegistry::createQuery(const std::string& label)
+{
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    d->add(Query, query, label);
+    Trace::instance().recordCreate(Query, query, 0, label);
+    Debug::instance().setLabel(Query, query, label);
+    return query;
+}
+
+void ResourceRegistry::deleteQuery(GLuint query)
+{
+    glDeleteQueries(1, &query);
+    d->remove(Query, query);
+    Trace::instance().recordDelete(Query, query);
+    Debug::instance().removeLabel(Query, query);
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the current statistics. The total is tracked on its own
+   so that its high-water marks are the peaks of all the categories
+   together.
+ * ---------------------------------------------------------------- */
+ResourceRegistry::Statistics ResourceRegistry::statistics() const
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    return d->stats;
+}
+
+/* ---------------------------------------------------------------- *
+   Prints the live objects with their labels and memory.
+ * ---------------------------------------------------------------- */
+int ResourceRegistry::reportLeaks() const
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    for (const auto& object : d->objects)
+    {
+        const Category category = Category(object.first.first);
+        std::cerr << "Leaked " << categoryName(category) << " "
+                  << object.first.second << " '"
+                  << object.second.label << "', "
+                  << object.second.bytes << " bytes" << std::endl;
+    }
+    return int(d->objects.size());
+}
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,151 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::ResourceRegistry class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "opengl.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A registry of the OpenGL resources. All the OpenGL objects are
+   created and deleted through the registry so that it knows how
+   many objects and how much memory is live per category. The data
+   stores of buffers, textures and renderbuffers are also allocated
+   through the registry to track the memory.
+
+   The registry is shared by the whole process. The OpenGL context
+   must be current when creating or deleting objects. The objects
+   still live when the context is torn down are reported as leaks.
+
+   The creations, deletions and data uploads are also recorded into
+   the trace while recording, see kuu::opengl::Trace. The labels are
+   given to the objects for the debug messages, see
+   kuu::opengl::Debug.
+
+   Example:
+
+    ResourceRegistry& registry = ResourceRegistry::instance();
+    GLuint vbo = registry.createBuffer("Quad VBO");
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    registry.bufferData(vbo, GL_ARRAY_BUFFER, size, data,
+                        GL_STATIC_DRAW);
+    ...
+    registry.deleteBuffer(vbo);
+    ...
+    registry.reportLeaks();
+
+ * ---------------------------------------------------------------- */
+class ResourceRegistry
+{
+public:
+    // Categories of the OpenGL objects.
+    enum Category
+    {
+        Buffer,
+        VertexArray,
+        Texture,
+        Renderbuffer,
+        Framebuffer,
+        Shader,
+        Program,
+        Query,
+        CategoryCount
+    };
+
+    // Statistics of a single category.
+    struct CategoryStatistics
+    {
+        int count           = 0; // live objects
+        int peakCount       = 0; // high-water mark of live objects
+        long long bytes     = 0; // live memory in bytes
+        long long peakBytes = 0; // high-water mark of live memory
+        long long created   = 0; // objects created in total
+        long long deleted   = 0; // objects deleted in total
+        long long allocated = 0; // bytes allocated in total
+    };
+
+    // Statistics of all the categories.
+    struct Statistics
+    {
+        CategoryStatistics categories[CategoryCount];
+        CategoryStatistics total;
+    };
+
+    // Returns the registry of the process.
+    static ResourceRegistry& instance();
+
+    // Returns the name of the category, e.g. "buffer".
+    static const char* categoryName(Category category);
+
+    // Creates and deletes buffers. The data is written into the
+    // buffer that must be bound into the target.
+    GLuint createBuffer(const std::string& label);
+    void bufferData(GLuint buffer, GLenum target, GLsizeiptr size,
+                    const void* data, GLenum usage);
+    void deleteBuffer(GLuint buffer);
+
+    // Creates and deletes vertex arrays.
+    GLuint createVertexArray(const std::string& label);
+    void deleteVertexArray(GLuint vertexArray);
+
+    // Creates and deletes 2D textures. The image is written into
+    // the texture that must be bound into GL_TEXTURE_2D.
+    GLuint createTexture(const std::string& label);
+    void textureImage2D(GLuint texture, GLint internalFormat,
+                        GLsizei width, GLsizei height,
+                        GLenum format, GLenum type,
+                        const void* data);
+    void deleteTexture(GLuint texture);
+
+    // Creates and deletes renderbuffers. The storage is allocated
+    // for the renderbuffer that must be bound. If the sample count
+    // is above zero then the storage is multisampled.
+    GLuint createRenderbuffer(const std::string& label);
+    void renderbufferStorage(GLuint renderbuffer, GLsizei samples,
+                             GLenum internalFormat,
+                             GLsizei width, GLsizei height);
+    void deleteRenderbuffer(GLuint renderbuffer);
+
+    // Creates and deletes framebuffers.
+    GLuint createFramebuffer(const std::string& label);
+    void deleteFramebuffer(GLuint framebuffer);
+
+    // Creates and deletes shaders and programs.
+    GLuint createShader(GLenum type, const std::string& label);
+    void deleteShader(GLuint shader);
+    GLuint createProgram(const std::string& label);
+    void deleteProgram(GLuint program);
+    // Registers a program that was linked without the registry in a
+    // shared context, e.g. on a worker thread. Called in the thread
+    // of the rendering context so that the label is set there. The
+    // creation is not recorded into the trace.
+    void adoptProgram(GLuint program, const std::string& label);
+
+    // Creates and deletes queries.
+    GLuint createQuery(const std::string& label);
+    void deleteQuery(GLuint query);
+
+    // Returns the current statistics.
+    Statistics statistics() const;
+
+    // Prints the live objects into standard error stream. Returns
+    // the count of live objects.
+    int reportLeaks() const;
+
+private:
+    ResourceRegistry();
+
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,240 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::Scene class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_scene.h"
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace kuu
+{
+namespace opengl
+{
+
+namespace
+{
+
+const int IndexBits = 20;                   // bits of the slot index
+const std::uint32_t IndexMask = (1u << IndexBits) - 1u;
+const std::uint32_t GenerationMask = 0xfffu; // 12 bits of generation
+const std::uint32_t MaxSlotCount = Scene::MaxObjectCount;
+
+// Returns the slot index of the handle.
+std::uint32_t slotIndex(Scene::Handle handle)
+{ return handle & IndexMask; }
+
+// Returns the generation of the handle.
+std::uint32_t generation(Scene::Handle handle)
+{ return handle >> IndexBits; }
+
+} // anonymous namespace
+
+const Scene::Handle Scene::InvalidHandle;
+const int Scene::MaxObjectCount;
+
+/* ---------------------------------------------------------------- *
+   The data of the scene. The slots map the handles into the dense
+   arrays and the dense-to-slot array maps back so that the slot of
+   the moved object can be updated on swap-remove.
+ * ---------------------------------------------------------------- */
+struct Scene::Data
+{
+    // A slot of a handle.
+    struct Slot
+    {
+        std::uint32_t dense;      // index in the dense arrays
+        std::uint32_t generation; // current generation of the slot
+        bool alive;               // true if an object uses the slot
+    };
+
+    // Returns the dense index of the handle or -1 if invalid.
+    int denseIndex(Handle handle) const
+    {
+        const std::uint32_t index = slotIndex(handle);
+        if (index >= slots.size())
+            return -1;
+        const Slot& slot = slots[index];
+        if (!slot.alive || slot.generation != generation(handle))
+            return -1;
+        return int(slot.dense);
+    }
+
+    // Slots of the handles and the free slot indices.
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> freeSlots;
+
+    // Dense component arrays.
+    std::vector<glm::mat4> transforms;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::quat> orientations;
+    std::vector<float> rotationRates;
+    std::vector<std::uint32_t> meshIds;
+    std::vector<Bounds> bounds;
+    std::vector<std::uint32_t> denseToSlot;
+};
+
+/* ---------------------------------------------------------------- *
+   Constructs the scene.
+ * -----------------------------------------------------------------*/
+Scene::Scene()
+    : d(std::make_shared<Data>())
+{}
+
+/* ---------------------------------------------------------------- *
+   Creates an object. A free slot is re-used if there is one. The
+   components are appended into the end of the dense arrays.
+ * -----------------------------------------------------------------*/
+Scene::Handle Scene::create(const glm::vec3& position,
+                            float rotationRate,
+                            std::uint32_t meshId,
+                            const Bounds& bounds)
+{
+    std::uint32_t index = 0;
+    if (!d->freeSlots.empty())
+    {
+        index = d->freeSlots.back();
+        d->freeSlots.pop_back();
+    }
+    else
+    {
+        if (d->slots.size() >= MaxSlotCount)
+            return InvalidHandle;
+
+        index = std::uint32_t(d->slots.size());
+        Data::Slot slot;
+        slot.dense      = 0;
+        slot.generation = 0;
+        slot.alive      = false;
+        d->slots.push_back(slot);
+    }
+
+    Data::Slot& slot = d->slots[index];
+    slot.dense = std::uint32_t(d->positions.size());
+    slot.alive = true;
+
+    d->transforms.push_back(glm::translate(glm::mat4(1.0f), position));
+    d->positions.push_back(position);
+    d->orientations.push_back(glm::quat());
+    d->rotationRates.push_back(rotationRate);
+    d->meshIds.push_back(meshId);
+    d->bounds.push_back(bounds);
+    d->denseToSlot.push_back(index);
+
+    return (slot.generation << IndexBits) | index;
+}
+
+/* ---------------------------------------------------------------- *
+   Destroys the object. The last object is moved into the place of
+   the destroyed object and the generation of the slot is increm-
+   ented.
+ * -----------------------------------------------------------------*/
+void Scene::destroy(Handle handle)
+{
+    const int dense = d->denseIndex(handle);
+    if (dense < 0)
+        return;
+
+    const std::size_t last = d->positions.size() - 1;
+    if (std::size_t(dense) != last)
+    {
+        d->transforms[dense]    = d->transforms[last];
+        d->positions[dense]     = d->positions[last];
+        d->orientations[dense]  = d->orientations[last];
+        d->rotationRates[dense] = d->rotationRates[last];
+        d->meshIds[dense]       = d->meshIds[last];
+        d->bounds[dense]        = d->bounds[last];
+        d->denseToSlot[dense]   = d->denseToSlot[last];
+        d->slots[d->denseToSlot[dense]].dense = std::uint32_t(dense);
+    }
+
+    d->transforms.pop_back();
+    d->positions.pop_back();
+    d->orientations.pop_back();
+    d->rotationRates.pop_back();
+    d->meshIds.pop_back();
+    d->bounds.pop_back();
+    d->denseToSlot.pop_back();
+
+    const std::uint32_t index = slotIndex(handle);
+    Data::Slot& slot = d->slots[index];
+    slot.alive = false;
+    slot.generation = (slot.generation + 1) & GenerationMask;
+    d->freeSlots.push_back(index);
+}
+
+/* ---------------------------------------------------------------- *
+   Returns true if the handle refers into an object.
+ * -----------------------------------------------------------------*/
+bool Scene::isValid(Handle handle) const
+{ return d->denseIndex(handle) >= 0; }
+
+/* ---------------------------------------------------------------- *
+   Returns the count of objects.
+ * -----------------------------------------------------------------*/
+int Scene::size() const
+{ return int(d->positions.size()); }
+
+/* ---------------------------------------------------------------- *
+   Sets the position of the object. The transform is updated on
+   the next update().
+ * -----------------------------------------------------------------*/
+void Scene::setPosition(Handle handle, const glm::vec3& position)
+{
+    const int dense = d->denseIndex(handle);
+    if (dense >= 0)
+        d->positions[dense] = position;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the position of the object.
+ * -----------------------------------------------------------------*/
+glm::vec3 Scene::position(Handle handle) const
+{
+    const int dense = d->denseIndex(handle);
+    if (dense < 0)
+        return glm::vec3(0.0f);
+    return d->positions[dense];
+}
+
+/* ---------------------------------------------------------------- *
+   Updates the rotations around y-axis and re-calculates the trans-
+   forms from the positions and orientations.
+ * -----------------------------------------------------------------*/
+void Scene::update(float elapsed)
+{
+    const glm::vec3 axis(0.0f, 1.0f, 0.0f);
+    const std::size_t count = d->positions.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const float angleChange = d->rotationRates[i] * elapsed;
+        d->orientations[i] *=
+            glm::angleAxis(glm::radians(angleChange), axis);
+
+        glm::mat4 transform = glm::mat4_cast(d->orientations[i]);
+        transform[3] = glm::vec4(d->positions[i], 1.0f);
+        d->transforms[i] = transform;
+    }
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the dense array of transforms.
+ * -----------------------------------------------------------------*/
+const glm::mat4* Scene::transforms() const
+{ return d->transforms.data(); }
+
+/* ---------------------------------------------------------------- *
+   Returns the dense array of mesh IDs.
+ * -----------------------------------------------------------------*/
+const std::uint32_t* Scene::meshIds() const
+{ return d->meshIds.data(); }
+
+/* ---------------------------------------------------------------- *
+   Returns the dense array of bounds.
+ * -----------------------------------------------------------------*/
+const Scene::Bounds* Scene::bounds() const
+{ return d->bounds.data(); }
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,105 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::Scene class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A scene of objects stored as a structure of arrays.
+
+   An object is referenced with a 32-bit handle that contains the
+   index of a slot and the generation of the slot. The generation
+   is incremented when the object is destroyed so an old handle
+   does not refer into a new object that re-uses the slot.
+
+   The components of the objects (transform, orientation, rotation
+   rate, mesh ID and bounds) are stored in dense arrays where the
+   objects are packed without holes. Destroying an object moves the
+   last object into its place. The update and the rendering iterate
+   the arrays linearly.
+
+   The scene does not know anything about OpenGL. The mesh ID is
+   an index of a mesh given by the renderer.
+
+   Example:
+
+    Scene scene;
+    Scene::Handle handle = scene.create(glm::vec3(0.0f), 0.18f, 0);
+    ...
+    scene.update(10.0f); // 10 milliseconds
+    for (int i = 0; i < scene.size(); ++i)
+        draw(scene.meshIds()[i], scene.transforms()[i]);
+    ...
+    scene.destroy(handle);
+
+ * ---------------------------------------------------------------- */
+class Scene
+{
+public:
+    // Defines a handle of an object.
+    using Handle = std::uint32_t;
+
+    // A handle that never refers into an object.
+    static const Handle InvalidHandle = 0xffffffffu;
+    // Maximum count of objects, 20 bits of the handle are the slot
+    // index and the last index is reserved.
+    static const int MaxObjectCount = (1 << 20) - 1;
+
+    // An axis-aligned bounding box in model space.
+    struct Bounds
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // Constructs an empty scene.
+    Scene();
+
+    // Creates an object at the position. The object rotates around
+    // y-axis with the rate given in degrees per millisecond. Returns
+    // InvalidHandle if the scene already has MaxObjectCount objects.
+    Handle create(const glm::vec3& position,
+                  float rotationRate,
+                  std::uint32_t meshId,
+                  const Bounds& bounds = Bounds());
+
+    // Destroys the object. Invalid handle is ignored.
+    void destroy(Handle handle);
+
+    // Returns true if the handle refers into an object.
+    bool isValid(Handle handle) const;
+
+    // Returns the count of objects.
+    int size() const;
+
+    // Sets and gets the position of the object.
+    void setPosition(Handle handle, const glm::vec3& position);
+    glm::vec3 position(Handle handle) const;
+
+    // Updates the object rotations and the transforms.
+    void update(float elapsed);
+
+    // Returns the dense component arrays. The arrays contain size()
+    // elements and are valid until the next create() or destroy().
+    const glm::mat4* transforms() const;
+    const std::uint32_t* meshIds() const;
+    const Bounds* bounds() const;
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
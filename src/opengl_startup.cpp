@@ -0,0 +1,335 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::Startup class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_startup.h"
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <utility>
+#include <QtCore/QThread>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include "opengl.h"
+#include "opengl_trace.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+namespace
+{
+
+// Shorthand aliases of clock
+using Clock = std::chrono::steady_clock;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+// Time of the static initialization, i.e. the process start.
+const Clock::time_point processStart = Clock::now();
+
+/* ---------------------------------------------------------------- *
+   Prepares the vertices and the shader sources of the scene. Called
+   on a worker thread.
+ * ---------------------------------------------------------------- */
+Startup::Assets prepareSceneAssets()
+{
+    Startup::Assets assets;
+    // A single 2 x 2 quad.
+    assets.meshes.push_back(Quad::prepare(2.0f, 2.0f));
+
+    Startup::instance().mark("assets prepared");
+    return assets;
+}
+
+/* ---------------------------------------------------------------- *
+   Compiles the shader of the given type. Returns 0 on failure. The
+   status is checked always as the program is linked again by the
+   rendering thread if this fails.
+ * ---------------------------------------------------------------- */
+GLuint compileShader(GLenum type, const std::string& source)
+{
+    const GLuint shader = glCreateShader(type);
+    const char* src = source.c_str();
+    glShaderSource(shader, 1, &src, NULL);
+    glCompileShader(shader);
+
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLchar log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        std::cerr << "Failed to compile shader on the worker thread"
+                  << std::endl << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+/* ---------------------------------------------------------------- *
+   Links the shader program of the mesh. Returns 0 on failure. The
+   resource registry, the debug output and the trace are not used
+   as they belong to the rendering thread.
+ * ---------------------------------------------------------------- */
+GLuint linkSceneProgram(const Quad::Source& mesh)
+{
+    const GLuint vsh = compileShader(GL_VERTEX_SHADER,
+                                     mesh.vertexShader);
+    const GLuint fsh = compileShader(GL_FRAGMENT_SHADER,
+                                     mesh.fragmentShader);
+    GLuint pgm = 0;
+    if (vsh != 0 && fsh != 0)
+    {
+        pgm = glCreateProgram();
+        glAttachShader(pgm, vsh);
+        glAttachShader(pgm, fsh);
+        glLinkProgram(pgm);
+
+        GLint status = 0;
+        glGetProgramiv(pgm, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE)
+        {
+            GLchar log[1024];
+            glGetProgramInfoLog(pgm, sizeof(log), NULL, log);
+            std::cerr << "Failed to link shader program on the worker "
+                      << "thread" << std::endl << log << std::endl;
+            glDeleteProgram(pgm);
+            pgm = 0;
+        }
+    }
+
+    // The shaders are flagged for deletion and freed with the program.
+    glDeleteShader(vsh);
+    glDeleteShader(fsh);
+    return pgm;
+}
+
+/* ---------------------------------------------------------------- *
+   A worker thread that links the shader programs of the prepared
+   assets. The shared context and the offscreen surface are created
+   in the UI thread, the context is moved into this thread and only
+   made current here. The context is deleted and the surface is
+   deleted in the UI thread afterwards.
+ * ---------------------------------------------------------------- */
+class LinkThread : public QThread
+{
+public:
+    LinkThread(std::future<Startup::Assets> prepared,
+               QOffscreenSurface* surface,
+               QOpenGLContext* context)
+        : prepared(std::move(prepared))
+        , surface(surface)
+        , context(context)
+    {}
+
+    // Returns the future of the linked assets.
+    std::future<Startup::Assets> linked()
+    { return promise.get_future(); }
+
+protected:
+    void run() override
+    {
+        Startup::Assets assets = prepared.get();
+        if (context->makeCurrent(surface))
+        {
+            Startup::instance().mark("shared context created");
+            for (Quad::Source& mesh : assets.meshes)
+                if (mesh.program == 0)
+                    mesh.program = linkSceneProgram(mesh);
+
+            // The link must be complete before the programs are used
+            // in the rendering context.
+            glFinish();
+            context->doneCurrent();
+            Startup::instance().mark("shaders linked");
+        }
+        else
+        {
+            std::cerr << "Failed to make shared OpenGL context current"
+                      << std::endl;
+        }
+
+        delete context;
+        surface->deleteLater();
+        promise.set_value(std::move(assets));
+    }
+
+private:
+    std::future<Startup::Assets> prepared; // assets without programs
+    std::promise<Startup::Assets> promise; // assets with programs
+    QOffscreenSurface* surface;            // deleted in the UI thread
+    QOpenGLContext* context;               // deleted in this thread
+};
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   The data of the startup.
+ * ---------------------------------------------------------------- */
+struct Startup::Data
+{
+    // Starts the preparation if not started. The mutex must be
+    // locked.
+    void startPreparation()
+    {
+        if (!assets.valid())
+            assets = std::async(std::launch::async,
+                                &prepareSceneAssets);
+    }
+
+    std::mutex mutex;               // guards the data
+    std::future<Assets> assets;     // assets being prepared
+    std::vector<std::pair<double, std::string>> timeline;
+    std::string timelineFile;       // empty if not written
+    bool finished = false;          // true if finished
+};
+
+/* ---------------------------------------------------------------- *
+   Returns the startup of the process.
+ * ---------------------------------------------------------------- */
+Startup& Startup::instance()
+{
+    static Startup startup;
+    return startup;
+}
+
+/* ---------------------------------------------------------------- *
+   Constructs the startup.
+ * ---------------------------------------------------------------- */
+Startup::Startup()
+    : d(std::make_shared<Data>())
+{}
+
+/* ---------------------------------------------------------------- *
+   Assets.
+ * ---------------------------------------------------------------- */
+void Startup::prepareAssets()
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->startPreparation();
+}
+
+void Startup::prepareShaders(QOpenGLContext* shareContext)
+{
+    if (!shareContext)
+        return;
+
+    // The trace must have the program creation in the order of the
+    // commands so the rendering thread links the programs.
+    if (Trace::instance().isRecording())
+        return;
+
+    // The offscreen surface and the shared context are created in the
+    // UI thread while the share context is not current anywhere.
+    QOffscreenSurface* surface = new QOffscreenSurface();
+    surface->setFormat(shareContext->format());
+    surface->create();
+    if (!surface->isValid())
+    {
+        std::cerr << "Failed to create offscreen surface"
+                  << std::endl;
+        delete surface;
+        return;
+    }
+
+    QOpenGLContext* context = new QOpenGLContext();
+    context->setFormat(shareContext->format());
+    context->setShareContext(shareContext);
+    if (!context->create() ||
+        !QOpenGLContext::areSharing(context, shareContext))
+    {
+        std::cerr << "Failed to create shared OpenGL context"
+                  << std::endl;
+        delete context;
+        delete surface;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->startPreparation();
+    LinkThread* thread =
+        new LinkThread(std::move(d->assets), surface, context);
+    d->assets = thread->linked();
+    context->moveToThread(thread);
+    QObject::connect(thread, &QThread::finished,
+                     thread, &QObject::deleteLater);
+    thread->start();
+}
+
+bool Startup::assetsReady()
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->startPreparation();
+    return d->assets.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+}
+
+Startup::Assets Startup::takeAssets()
+{
+    std::future<Assets> assets;
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->startPreparation();
+        assets = std::move(d->assets);
+    }
+    return assets.get();
+}
+
+/* ---------------------------------------------------------------- *
+   Timeline.
+ * ---------------------------------------------------------------- */
+void Startup::mark(const std::string& event)
+{
+    const double time =
+        Milliseconds(Clock::now() - processStart).count();
+
+    std::lock_guard<std::mutex> lock(d->mutex);
+    if (!d->finished)
+        d->timeline.push_back(std::make_pair(time, event));
+}
+
+void Startup::setTimelineFile(const std::string& filePath)
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->timelineFile = filePath;
+}
+
+/* ---------------------------------------------------------------- *
+   Prints the timeline and writes it into the file.
+ * ---------------------------------------------------------------- */
+void Startup::finish()
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    if (d->finished)
+        return;
+    d->finished = true;
+
+    std::cout << "startup:";
+    for (std::size_t i = 0; i < d->timeline.size(); ++i)
+        std::cout << (i > 0 ? ", " : " ")
+                  << d->timeline[i].second << " "
+                  << d->timeline[i].first << " ms";
+    std::cout << std::endl;
+
+    if (d->timelineFile.empty())
+        return;
+
+    std::ofstream file(d->timelineFile);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open startup timeline file "
+                  << d->timelineFile << std::endl;
+        return;
+    }
+
+    for (const auto& event : d->timeline)
+        file << event.first << " " << event.second << "\n";
+}
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,110 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::Startup class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "opengl_quad.h"
+
+class QOpenGLContext;
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A startup pipeline of the application.
+
+   The vertices and the shader sources of the scene are prepared on
+   a worker thread while the window is created. When the context of
+   the surface is created the shader programs are compiled and linked
+   on a worker thread too. The UI thread creates a context on an off-
+   screen surface that shares the objects with the surface context
+   before the rendering thread starts, the worker only makes it
+   current. The rendering thread presents a cleared frame first and
+   creates the buffers of the scene from the assets after it, the
+   linked programs are registered and labeled there. If the programs
+   are not prepared then they are linked by the rendering thread.
+   If the preparation is not started before the assets are needed
+   then it is started on demand.
+
+   The startup events are marked into a timeline with the time since
+   the process start. The process start is the time of the static
+   initialization of the application. When the startup is finished
+   the timeline is printed into standard output and written into
+   the timeline file if one is set. The file has a line per event of
+   the milliseconds and the name of the event.
+
+   Example:
+
+    Startup& startup = Startup::instance();
+    startup.setTimelineFile("startup.txt");
+    startup.prepareAssets();
+    ...
+    // UI thread, the context has been created but is not current
+    startup.prepareShaders(context);
+    ...
+    // rendering thread
+    startup.mark("first frame");
+    ...
+    if (startup.assetsReady())
+    {
+        const Startup::Assets assets = startup.takeAssets();
+        ...
+        startup.mark("loaded");
+        startup.finish();
+    }
+
+ * ---------------------------------------------------------------- */
+class Startup
+{
+public:
+    // The assets of the scene. The mesh ID of a scene object is an
+    // index into the meshes.
+    struct Assets
+    {
+        std::vector<Quad::Source> meshes;
+    };
+
+    // Returns the startup of the process.
+    static Startup& instance();
+
+    // Starts preparing the assets on a worker thread. Does nothing
+    // if the preparation is already started.
+    void prepareAssets();
+    // Starts compiling and linking the shader programs of the assets
+    // on a worker thread with a context that is shared with the given
+    // context. Must be called from the UI thread before the rendering
+    // thread starts. If the shared context cannot be created or a
+    // trace is being recorded then the programs are not linked.
+    void prepareShaders(QOpenGLContext* shareContext);
+    // Returns true if the prepared assets can be taken without
+    // waiting. Starts the preparation if it is not started.
+    bool assetsReady();
+    // Returns the prepared assets, waits for the worker thread if
+    // needed. The next assets are prepared again.
+    Assets takeAssets();
+
+    // Marks the event into the timeline. Can be called from any
+    // thread.
+    void mark(const std::string& event);
+    // Sets the file where the timeline is written into.
+    void setTimelineFile(const std::string& filePath);
+    // Finishes the startup. The timeline is printed and written into
+    // the file. The later calls do nothing.
+    void finish();
+
+private:
+    Startup();
+
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,52 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::Surface interface.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   An interface of a surface that the rendering thread draws into.
+   The surface owns the OpenGL context and the thread drives it
+   through this interface only, so the same thread can render on
+   any backend (see kuu::opengl::Widget and kuu::opengl::Window).
+
+   All the functions are called from the rendering thread.
+ * ---------------------------------------------------------------- */
+class Surface
+{
+public:
+    // Defines a shared and weak pointers of surface.
+    using Ptr     = std::shared_ptr<Surface>;
+    using WeakPtr = std::weak_ptr<Surface>;
+
+    // Destroys the surface.
+    virtual ~Surface() {}
+
+    // Makes the surface context current in the calling thread.
+    virtual void makeCurrent() = 0;
+
+    // Swaps the surface front and back buffers.
+    virtual void swapBuffers() = 0;
+
+    // Sets "no context" as the current context.
+    virtual void doneCurrent() = 0;
+
+    // Moves the surface context back into the UI thread. Called
+    // last before the rendering thread exits so that the thread can
+    // be started again. The context must not be current.
+    virtual void releaseContext() = 0;
+
+    // Returns the name of the backend, e.g. "widget".
+    virtual const char* backendName() const = 0;
+};
+
+} // namespace opengl
+} // namespace kuu
@@ -4,10 +4,27 @@
  * ---------------------------------------------------------------- */
 
 #include "opengl_thread.h"
+#include <algorithm>
 #include <chrono>
+#include <ctime>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
 #include <glm/gtx/transform.hpp>
+#include "opengl.h"
+#include "opengl_debug.h"
+#include "opengl_frame_limiter.h"
+#include "opengl_framebuffer.h"
+#include "opengl_fxaa.h"
+#include "opengl_gpu_timer.h"
 #include "opengl_quad.h"
+#include "opengl_resolution_scaler.h"
+#include "opengl_resource_registry.h"
+#include "opengl_scene.h"
+#include "opengl_startup.h"
+#include "opengl_trace.h"
 
 namespace kuu
 {
@@ -47,42 +64,559 @@ private:
     ClockTimePoint prevTime_; // previous sampling time
 };
 
+namespace
+{
+
+/* ---------------------------------------------------------------- *
+   Renders the scene objects with the meshes. The objects are drawn
+   in the order of the dense arrays and a mesh is bound only when
+   the mesh ID changes between two successive objects.
+ * ---------------------------------------------------------------- */
+void renderScene(const Scene& scene,
+                 const std::vector<Quad::Ptr>& meshes,
+                 const glm::mat4& viewProjection)
+{
+    const glm::mat4* transforms = scene.transforms();
+    const std::uint32_t* meshIds = scene.meshIds();
+    const int count = scene.size();
+
+    Quad* mesh = nullptr;
+    for (int i = 0; i < count; ++i)
+    {
+        if (meshIds[i] >= meshes.size())
+            continue;
+
+        Quad* objectMesh = meshes[meshIds[i]].get();
+        if (objectMesh != mesh)
+        {
+            if (mesh)
+                mesh->release();
+            mesh = objectMesh;
+            mesh->bind();
+        }
+        mesh->draw(viewProjection * transforms[i]);
+    }
+
+    if (mesh)
+        mesh->release();
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the name of the anti-aliasing mode.
+ * ---------------------------------------------------------------- */
+std::string antiAliasingName(Thread::AntiAliasing mode, int samples)
+{
+    switch (mode)
+    {
+        case Thread::AntiAliasing::Off:
+            return "off";
+        case Thread::AntiAliasing::Msaa:
+            return "msaa x" + std::to_string(samples);
+        case Thread::AntiAliasing::Fxaa:
+            return "fxaa";
+    }
+    return std::string();
+}
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   Collects the frame time and the present latency of the frames
+   and prints the averages into standard output once a second.
+
+   The frame time is the time between the starts of two frames.
+   The present latency is the time spent in the buffer swap call.
+   The GPU time is the time the GPU spent on rendering the frame.
+   The latency is the time from the frame submission into the GPU
+   completion of the frame. The live OpenGL objects, their memory
+   and the object allocation rate come from the resource registry.
+   The sync calls are the calls that force the CPU to wait for the
+   driver, see kuu::opengl::Debug. An increase of the maximum count
+   per frame is warned about.
+
+   The CPU usage is the process CPU time per wall time, including
+   the time the thread has been idle. While the thread sleeps the
+   CPU usage is still printed once a second. Note that on Windows
+   the CPU time of std::clock() is the wall time.
+ * ---------------------------------------------------------------- */
+class FrameStatistics
+{
+public:
+    // Shorthand aliases of clock
+    using Clock = std::chrono::steady_clock;
+    using ClockTimePoint = Clock::time_point;
+
+    // Constructs the statistics of the given in backend.
+    FrameStatistics(const std::string& backendName)
+        : backendName_(backendName)
+    {
+        reset(Clock::now());
+    }
+
+    // Marks that the thread has been idle since the previous
+    // frame. The idle time is not counted into the frame time.
+    void resume()
+    {
+        idle_ = true;
+    }
+
+    // Marks the start of a frame.
+    void beginFrame()
+    {
+        const ClockTimePoint now = Clock::now();
+        if (frameCount_ > 0 && !idle_)
+            frameTime_ += now - frameStart_;
+        else if (frameCount_ > 0)
+            frameCount_--;
+        idle_ = false;
+        frameStart_ = now;
+        frameCount_++;
+
+        if (now - reportTime_ >= std::chrono::seconds(1))
+        {
+            print();
+            reset(now);
+        }
+    }
+
+    // Marks that the thread is sleeping. Called periodically while
+    // there is nothing to render so that the CPU usage is printed
+    // also when no frames are rendered.
+    void sleeping()
+    {
+        const ClockTimePoint now = Clock::now();
+        if (now - reportTime_ >= std::chrono::seconds(1))
+        {
+            print();
+            reset(now);
+        }
+    }
+
+    // Marks the start of the buffer swap.
+    void beginPresent()
+    {
+        presentStart_ = Clock::now();
+    }
+
+    // Marks the end of the buffer swap.
+    void endPresent()
+    {
+        presentTime_ += Clock::now() - presentStart_;
+        presentCount_++;
+    }
+
+    // Adds a GPU time measurement in milliseconds.
+    void addGpuTime(double milliseconds)
+    {
+        gpuTime_ += milliseconds;
+        gpuCount_++;
+    }
+
+    // Adds a submit-to-complete latency in milliseconds.
+    void addLatency(double milliseconds)
+    {
+        latency_ += milliseconds;
+        latencyCount_++;
+    }
+
+    // Sets the name of the current anti-aliasing mode.
+    void setAntiAliasing(const std::string& name)
+    {
+        antiAliasing_ = name;
+    }
+
+    // Sets the current resolution scale and budget hit-rate. These
+    // are printed only if the adaptive resolution is enabled.
+    void setResolution(bool adaptive, double scale, double hitRate)
+    {
+        adaptive_ = adaptive;
+        scale_    = scale;
+        hitRate_  = hitRate;
+    }
+
+    // Adds the count of sync-forcing calls of a frame.
+    void addSyncCalls(int count)
+    {
+        syncCalls_ += count;
+        syncMax_    = std::max(syncMax_, count);
+        syncFrames_++;
+    }
+
+private:
+    // Prints the averages into standard output.
+    void print() const
+    {
+        using namespace std::chrono;
+        using Milliseconds = duration<double, std::milli>;
+
+        const int frames = frameCount_ - 1;
+        const auto wallDuration = Clock::now() - reportTime_;
+        const double wallTime =
+            duration_cast<Milliseconds>(wallDuration).count();
+        const double cpuTime =
+            1000.0 * double(std::clock() - cpuStart_) / CLOCKS_PER_SEC;
+
+        // Mostly idle, e.g. a static scene in on-demand mode. There
+        // is no frame time but the CPU usage is printed.
+        if (frames <= 0 || presentCount_ <= 0)
+        {
+            std::cout << backendName_ << ": "
+                      << "idle, " << presentCount_ << " frames";
+            if (wallTime > 0.0)
+                std::cout << ", cpu " << 100.0 * cpuTime / wallTime
+                          << " %";
+            std::cout << std::endl;
+            return;
+        }
+
+        const double frameTime =
+            duration_cast<Milliseconds>(frameTime_).count() / frames;
+        const double presentTime =
+            duration_cast<Milliseconds>(presentTime_).count() /
+            presentCount_;
+
+        std::cout << backendName_ << ": "
+                  << "frame "   << frameTime   << " ms, "
+                  << "present " << presentTime << " ms";
+        if (gpuCount_ > 0)
+            std::cout << ", gpu " << gpuTime_ / gpuCount_ << " ms"
+                      << " (aa " << antiAliasing_ << ")";
+        if (latencyCount_ > 0)
+            std::cout << ", latency " << latency_ / latencyCount_
+                      << " ms";
+        if (adaptive_)
+            std::cout << ", scale "    << scale_
+                      << ", hit-rate " << hitRate_ * 100.0 << " %";
+        if (wallTime > 0.0)
+            std::cout << ", cpu " << 100.0 * cpuTime / wallTime << " %";
+        std::cout << std::endl;
+
+        const ResourceRegistry::Statistics registry =
+            ResourceRegistry::instance().statistics();
+        const ResourceRegistry::CategoryStatistics& resources =
+            registry.total;
+        const double allocations =
+            double(resources.created - prevCreated_) / frames;
+        std::cout << backendName_ << ": "
+                  << "objects " << resources.count
+                  << " (peak " << resources.peakCount << "), "
+                  << "memory "  << resources.bytes / 1024
+                  << " KiB (peak " << resources.peakBytes / 1024
+                  << " KiB), "
+                  << "allocations " << allocations << " per frame";
+        if (syncFrames_ > 0)
+            std::cout << ", sync calls "
+                      << double(syncCalls_) / syncFrames_
+                      << " per frame (max " << syncMax_ << ")";
+        if (Debug::instance().isInstalled())
+            std::cout << ", gl errors "
+                      << Debug::instance().errorCount();
+        std::cout << std::endl;
+
+        // Memory of the categories that have live objects.
+        std::cout << backendName_ << ": memory by category";
+        for (int i = 0; i < ResourceRegistry::CategoryCount; ++i)
+        {
+            const ResourceRegistry::CategoryStatistics& c =
+                registry.categories[i];
+            if (c.count == 0)
+                continue;
+            std::cout << ", "
+                      << ResourceRegistry::categoryName(
+                             ResourceRegistry::Category(i))
+                      << " " << c.count << " / "
+                      << c.bytes / 1024 << " KiB";
+        }
+        std::cout << std::endl;
+    }
+
+    // Compares the maximum count of sync-forcing calls per frame
+    // against the count of the first reported period. An increase is
+    // a regression, e.g. a state query added into the frame.
+    void checkSyncCalls()
+    {
+        if (syncFrames_ == 0)
+            return;
+
+        if (syncBaseline_ < 0)
+        {
+            syncBaseline_ = syncMax_;
+            return;
+        }
+
+        if (syncMax_ > syncBaseline_)
+        {
+            std::cerr << backendName_ << ": "
+                      << "sync calls per frame increased from "
+                      << syncBaseline_ << " to " << syncMax_
+                      << std::endl;
+            syncBaseline_ = syncMax_;
+        }
+    }
+
+    // Resets the accumulated times.
+    void reset(const ClockTimePoint& now)
+    {
+        checkSyncCalls();
+        cpuStart_     = std::clock();
+        prevCreated_  =
+            ResourceRegistry::instance().statistics().total.created;
+        reportTime_   = now;
+        frameTime_    = Clock::duration::zero();
+        presentTime_  = Clock::duration::zero();
+        frameCount_   = frameCount_ > 0 ? 1 : 0;
+        presentCount_ = 0;
+        gpuTime_      = 0.0;
+        gpuCount_     = 0;
+        latency_      = 0.0;
+        latencyCount_ = 0;
+        syncCalls_    = 0;
+        syncMax_      = 0;
+        syncFrames_   = 0;
+    }
+
+    std::string backendName_;     // name of the surface backend
+    ClockTimePoint reportTime_;   // time of the previous print
+    ClockTimePoint frameStart_;   // start time of the current frame
+    ClockTimePoint presentStart_; // start time of the buffer swap
+    Clock::duration frameTime_;   // accumulated frame time
+    Clock::duration presentTime_; // accumulated present time
+    std::clock_t cpuStart_;       // CPU time of the previous print
+    int frameCount_   = 0;        // count of started frames
+    bool idle_        = false;    // true if idle after the frame
+    int presentCount_ = 0;        // count of buffer swaps
+    double gpuTime_   = 0.0;      // accumulated GPU time
+    int gpuCount_     = 0;        // count of GPU time measurements
+    double latency_   = 0.0;      // accumulated latency
+    int latencyCount_ = 0;        // count of latency measurements
+    long long prevCreated_ = 0;   // objects created at previous print
+    std::string antiAliasing_;    // name of the anti-aliasing mode
+    bool adaptive_    = false;    // true if adaptive resolution
+    double scale_     = 1.0;      // current resolution scale
+    double hitRate_   = 1.0;      // current budget hit-rate
+    int syncCalls_    = 0;        // accumulated sync-forcing calls
+    int syncMax_      = 0;        // maximum sync calls of a frame
+    int syncFrames_   = 0;        // count of sync call measurements
+    int syncBaseline_ = -1;       // maximum of the first period
+};
+
 /* ---------------------------------------------------------------- *
    The data of the thread.
  * ---------------------------------------------------------------- */
 struct Thread::Data
 {
-    Data(Widget::WeakPtr openglWidget)
-        : openglWidget(openglWidget)
+    Data(Surface::WeakPtr openglSurface, const Settings& settings)
+        : openglSurface(openglSurface)
         , initialized(false)
         , render(true)
         , viewportWidth(720)
         , viewportHeight(576)
+        , targetFrameTime(settings.targetFrameTime)
+        , resolutionScale(1.0)
+        , budgetHitRate(1.0)
+        , maxFramesInFlight(settings.maxFramesInFlight)
+        , antiAliasing(settings.antiAliasing)
+        , samples(settings.samples)
+        , onDemand(settings.onDemand)
+        , dirty(true)
+        , animating(true)
+        , paused(false)
     {}
 
-    Widget::WeakPtr openglWidget;
+    // Returns true if the thread has nothing to render. The mutex
+    // must be locked.
+    bool idle() const
+    { return paused || (onDemand && !animating && !dirty); }
+
+    Surface::WeakPtr openglSurface;
     bool initialized;
     bool render;
     int viewportWidth;
     int viewportHeight;
+    double targetFrameTime; // 0.0 if adaptive resolution is disabled
+    double resolutionScale;
+    double budgetHitRate;
+    int maxFramesInFlight;
+    AntiAliasing antiAliasing;
+    int samples;    // sample count of MSAA
+    bool onDemand;  // true if rendering only when needed
+    bool dirty;     // true if the scene needs to be rendered
+    bool animating; // true if the scene is animated
+    bool paused;    // true if the surface is hidden or unexposed
     QMutex mutex;
+    QWaitCondition condition; // wakes the idle thread
 };
 
 /* ---------------------------------------------------------------- *
    Constructs the thread.
  * -----------------------------------------------------------------*/
-Thread::Thread(Widget::WeakPtr openglWidget)
-    : d(std::make_shared<Data>(openglWidget))
+Thread::Thread(Surface::WeakPtr openglSurface)
+    : Thread(openglSurface, Settings())
+{}
+
+Thread::Thread(Surface::WeakPtr openglSurface,
+               const Settings& settings)
+    : d(std::make_shared<Data>(openglSurface, settings))
 {}
 
+/* ---------------------------------------------------------------- *
+   Sets the viewport size. The new size is rendered even if the
+   scene would be static.
+ * ---------------------------------------------------------------- */
 void Thread::setViewportSize(int width, int height)
 {
     d->mutex.lock();
     d->viewportWidth  = width;
     d->viewportHeight = height;
+    d->dirty = true;
+    d->condition.wakeAll();
+    d->mutex.unlock();
+}
+
+/* ---------------------------------------------------------------- *
+   Sets the on-demand rendering. When on, a frame is rendered only
+   if the scene is animated or it has been marked dirty and other-
+   wise the thread sleeps. When off, the thread renders frames
+   continuously.
+ * ---------------------------------------------------------------- */
+void Thread::setOnDemand(bool onDemand)
+{
+    d->mutex.lock();
+    d->onDemand = onDemand;
+    d->dirty = true;
+    d->condition.wakeAll();
+    d->mutex.unlock();
+}
+
+/* ---------------------------------------------------------------- *
+   Marks the scene dirty so that a frame is rendered. Call this
+   after editing the scene or when the surface needs a repaint.
+ * ---------------------------------------------------------------- */
+void Thread::requestRender()
+{
+    d->mutex.lock();
+    d->dirty = true;
+    d->condition.wakeAll();
+    d->mutex.unlock();
+}
+
+/* ---------------------------------------------------------------- *
+   Sets the scene animation on or off. A stopped scene is static
+   and is not re-rendered in on-demand mode.
+ * ---------------------------------------------------------------- */
+void Thread::setAnimating(bool animating)
+{
+    d->mutex.lock();
+    d->animating = animating;
+    d->dirty = true;
+    d->condition.wakeAll();
     d->mutex.unlock();
 }
 
+/* ---------------------------------------------------------------- *
+   Returns true if the scene is animated.
+ * ---------------------------------------------------------------- */
+bool Thread::isAnimating() const
+{
+    d->mutex.lock();
+    const bool animating = d->animating;
+    d->mutex.unlock();
+    return animating;
+}
+
+/* ---------------------------------------------------------------- *
+   Pauses the rendering. The surface calls this when it is hidden,
+   minimized or not exposed. A frame is rendered on resume.
+ * ---------------------------------------------------------------- */
+void Thread::setPaused(bool paused)
+{
+    d->mutex.lock();
+    d->paused = paused;
+    d->dirty = true;
+    d->condition.wakeAll();
+    d->mutex.unlock();
+}
+
+/* ---------------------------------------------------------------- *
+   Sets the target frame time in milliseconds. A positive target
+   enables the adaptive resolution where the scene is rendered into
+   an offscreen framebuffer whose size is scaled to fit the frames
+   into the target. Zero disables the adaptive resolution.
+ * ---------------------------------------------------------------- */
+void Thread::setTargetFrameTime(double milliseconds)
+{
+    d->mutex.lock();
+    d->targetFrameTime = milliseconds;
+    d->mutex.unlock();
+}
+
+/* ---------------------------------------------------------------- *
+   Sets the maximum count of frames that the CPU can submit before
+   the GPU has finished them. The limit is from 1 to 3 frames; 1
+   gives the lowest latency and 3 the highest throughput.
+ * ---------------------------------------------------------------- */
+void Thread::setMaxFramesInFlight(int frames)
+{
+    d->mutex.lock();
+    d->maxFramesInFlight = frames;
+    d->mutex.unlock();
+}
+
+/* ---------------------------------------------------------------- *
+   Sets the anti-aliasing mode. The change is applied on the next
+   frame.
+ * ---------------------------------------------------------------- */
+void Thread::setAntiAliasing(AntiAliasing mode, int samples)
+{
+    d->mutex.lock();
+    d->antiAliasing = mode;
+    d->samples = samples;
+    d->dirty = true;
+    d->condition.wakeAll();
+    d->mutex.unlock();
+}
+
+/* ---------------------------------------------------------------- *
+   Switches from off into MSAA, from MSAA into FXAA and from FXAA
+   into off.
+ * ---------------------------------------------------------------- */
+void Thread::cycleAntiAliasing()
+{
+    d->mutex.lock();
+    switch (d->antiAliasing)
+    {
+        case AntiAliasing::Off:  d->antiAliasing = AntiAliasing::Msaa; break;
+        case AntiAliasing::Msaa: d->antiAliasing = AntiAliasing::Fxaa; break;
+        case AntiAliasing::Fxaa: d->antiAliasing = AntiAliasing::Off;  break;
+    }
+    d->dirty = true;
+    d->condition.wakeAll();
+    d->mutex.unlock();
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the current resolution scale.
+ * ---------------------------------------------------------------- */
+double Thread::resolutionScale() const
+{
+    d->mutex.lock();
+    const double scale = d->resolutionScale;
+    d->mutex.unlock();
+    return scale;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the ratio of the recent frames that fit into the target
+   frame time.
+ * ---------------------------------------------------------------- */
+double Thread::budgetHitRate() const
+{
+    d->mutex.lock();
+    const double hitRate = d->budgetHitRate;
+    d->mutex.unlock();
+    return hitRate;
+}
+
 /* ---------------------------------------------------------------- *
    Starts the rendering thread if it is not running already.
  * ---------------------------------------------------------------- */
@@ -102,6 +636,7 @@ void Thread::stop()
 {
     d->mutex.lock();
     d->render = false;
+    d->condition.wakeAll();
     d->mutex.unlock();
 
     quit();
@@ -110,38 +645,102 @@ void Thread::stop()
 
 /* ---------------------------------------------------------------- *
    Runs the OpenGL rendering until the user stops it by calling
-   stop() or the widget pointer goes invalid. If the operating
+   stop() or the surface pointer goes invalid. If the operating
    system is Windows then the GLEW is initialized before rendering.
 * ---------------------------------------------------------------- */
 void Thread::run()
 {
-    // Quad that is going to be render
-    Quad::Ptr quad;
-    // Timer for rotating the quad.
+    // Meshes of the scene, the mesh ID is an index into this.
+    std::vector<Quad::Ptr> meshes;
+    // Scene that is going to be render
+    Scene scene;
+    // Timer for rotating the scene objects.
     ElapsedTimer timer;
+    // Frame time and present latency, created on the first frame.
+    std::shared_ptr<FrameStatistics> stats;
+    // GPU time of the frame.
+    GpuTimer::Ptr gpuTimer;
+    // Offscreen framebuffers, created when the adaptive resolution
+    // or the anti-aliasing is enabled. The resolve framebuffer is
+    // used only with MSAA.
+    Framebuffer::Ptr sceneFramebuffer;
+    Framebuffer::Ptr resolveFramebuffer;
+    // Post-process pass of FXAA, created on first use.
+    Fxaa::Ptr fxaa;
+    // Controller of the adaptive resolution scale.
+    ResolutionScaler scaler;
+    // Maximum sample count of the context.
+    GLint maxSamples = 0;
+    // True if MSAA was requested but is not available.
+    bool msaaWarned = false;
+    // Limiter of the frames in-flight.
+    FrameLimiter limiter;
+    // Recorder of the command stream.
+    Trace& trace = Trace::instance();
+    // Debug output and the count of sync-forcing calls.
+    Debug& debug = Debug::instance();
+    // Assets and timeline of the startup.
+    Startup& startup = Startup::instance();
+    // Startup state, the scene is created after the first frame.
+    bool firstFramePresented = false;
+    bool sceneLoaded = false;
 
-    // Render until the thread is stopped or widget is deleted.
+    // Render until the thread is stopped or surface is deleted.
     for(;;)
     {
         int w = 0, h = 0;
         bool render = true;
+        double targetFrameTime = 0.0;
+        int maxFramesInFlight = 2;
+        bool animating = true;
+        bool waited = false;
+        AntiAliasing antiAliasing = AntiAliasing::Off;
+        int samples = 0;
 
+        // Sleep while there is nothing to render.
         d->mutex.lock();
+        while (d->render && d->idle())
+        {
+            // Wake once a second to print the idle CPU usage.
+            if (!d->condition.wait(&d->mutex, 1000) && stats)
+                stats->sleeping();
+            waited = true;
+        }
+        d->dirty = false;
+        animating = d->animating;
         render = d->render;
         w = d->viewportWidth;
         h = d->viewportHeight;
+        targetFrameTime = d->targetFrameTime;
+        maxFramesInFlight = d->maxFramesInFlight;
+        antiAliasing = d->antiAliasing;
+        samples = d->samples;
         d->mutex.unlock();
 
         if (!render)
             break;
 
-        // Get the widget pointer.
-        Widget::Ptr widget = d->openglWidget.lock();
-        if (!widget)
+        // Do not count the sleep as animation or frame time.
+        if (waited)
+        {
+            timer.elapsed();
+            if (stats)
+                stats->resume();
+        }
+
+        // Get the surface pointer.
+        Surface::Ptr surface = d->openglSurface.lock();
+        if (!surface)
             break;
 
-        // Make the widget context current.
-        widget->makeCurrent();
+        if (!stats)
+            stats = std::make_shared<FrameStatistics>(
+                surface->backendName());
+        stats->beginFrame();
+
+        // Make the surface context current.
+        surface->makeCurrent();
+        trace.beginFrame(w, h);
 
         // Initialize OpenGL if needed.
         if (!d->initialized)
@@ -153,13 +752,149 @@ void Thread::run()
             {
                 std::cerr << "Failed to initialize GLEW."
                           << std::endl;
-                return;
+                surface->doneCurrent();
+                break;
             }
 #endif
-            quad = std::make_shared<Quad>(2.0f, 2.0f);
+            // Install before creating objects so they get labels.
+            debug.install();
+
+            gpuTimer = std::make_shared<GpuTimer>();
+            glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
             d->initialized = true;
+            startup.mark("context initialized");
+
+            // The initialization is not part of the frame.
+            debug.takeSyncCalls();
+        }
+
+        // Create the scene from the assets prepared by the worker
+        // thread. The first frame is presented before this.
+        if (meshes.empty() && firstFramePresented &&
+            startup.assetsReady())
+        {
+            const Startup::Assets assets = startup.takeAssets();
+            for (const Quad::Source& source : assets.meshes)
+                meshes.push_back(std::make_shared<Quad>(source));
+
+            // A single rotating 2 x 2 quad at the origo.
+            Scene::Bounds bounds;
+            bounds.min = glm::vec3(-1.0f, -1.0f, 0.0f);
+            bounds.max = glm::vec3( 1.0f,  1.0f, 0.0f);
+            scene.create(glm::vec3(0.0f), 180.0f / 1000.0f, 0, bounds);
+            startup.mark("scene created");
+
+            // Start animating from the first frame of the scene. The
+            // creation is not part of the frame.
+            timer.elapsed();
+            debug.takeSyncCalls();
+        }
+
+        // Present a cleared frame until the scene is loaded. It is
+        // cheap so the first frame is shown as soon as possible.
+        if (meshes.empty())
+        {
+            trace.viewport(0, 0, w, h);
+            trace.clearColor(0.0f, 0.0f, 0.2f, 1.0f);
+            trace.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            stats->beginPresent();
+            surface->swapBuffers();
+            stats->endPresent();
+            trace.endFrame();
+            surface->doneCurrent();
+
+            if (!firstFramePresented)
+                startup.mark("first frame");
+            firstFramePresented = true;
+
+            // Sleep until the assets are ready instead of presenting
+            // more cleared frames. The wait is short as the startup
+            // does not signal the condition. A stop or a change of the
+            // surface wakes the thread earlier.
+            d->mutex.lock();
+            while (d->render && !d->dirty && !startup.assetsReady())
+                d->condition.wait(&d->mutex, 5);
+            // Render the next frame also in on-demand mode.
+            d->dirty = true;
+            d->mutex.unlock();
+
+            // The wait is not a part of a frame.
+            stats->resume();
+            continue;
+        }
+
+        // Wait until the GPU has caught up with the limit.
+        limiter.setMaxFramesInFlight(maxFramesInFlight);
+        limiter.waitForFrame();
+
+        // Scale the render size if the adaptive resolution is on.
+        const bool adaptive = targetFrameTime > 0.0;
+        int renderWidth  = w;
+        int renderHeight = h;
+        if (adaptive)
+        {
+            scaler.setTargetFrameTime(targetFrameTime);
+            renderWidth  = std::max(1, int(w * scaler.scale() + 0.5));
+            renderHeight = std::max(1, int(h * scaler.scale() + 0.5));
+        }
+
+        // Render into offscreen framebuffer if the result needs to be
+        // scaled, resolved or post-processed.
+        samples = std::min(std::max(samples, 0), int(maxSamples));
+        const bool msaa = antiAliasing == AntiAliasing::Msaa &&
+                          samples > 1;
+        const bool postProcess = antiAliasing == AntiAliasing::Fxaa;
+        const bool offscreen = adaptive || msaa || postProcess;
+
+        // MSAA needs at least two samples, otherwise it is off.
+        AntiAliasing activeAntiAliasing = antiAliasing;
+        if (antiAliasing == AntiAliasing::Msaa && !msaa)
+        {
+            activeAntiAliasing = AntiAliasing::Off;
+            if (!msaaWarned)
+                std::cerr << "MSAA needs at least 2 samples (maximum "
+                          << maxSamples << "), anti-aliasing is off"
+                          << std::endl;
+        }
+        msaaWarned = activeAntiAliasing != antiAliasing;
+        stats->setAntiAliasing(
+            antiAliasingName(activeAntiAliasing, samples));
+
+        if (offscreen)
+        {
+            const int sceneSamples = msaa ? samples : 0;
+            if (!sceneFramebuffer)
+                sceneFramebuffer = std::make_shared<Framebuffer>(
+                    renderWidth, renderHeight, sceneSamples);
+            else
+                sceneFramebuffer->resize(
+                    renderWidth, renderHeight, sceneSamples);
+            sceneFramebuffer->bind();
+        }
+        else
+        {
+            sceneFramebuffer.reset();
+        }
+
+        if (msaa)
+        {
+            if (!resolveFramebuffer)
+                resolveFramebuffer = std::make_shared<Framebuffer>(
+                    renderWidth, renderHeight);
+            else
+                resolveFramebuffer->resize(renderWidth, renderHeight);
+        }
+        else
+        {
+            resolveFramebuffer.reset();
         }
 
+        if (postProcess && !fxaa)
+            fxaa = std::make_shared<Fxaa>();
+
+        gpuTimer->begin();
+
         // Perspective projection matrix
         const float aspect = float(w) / float(h);
         const glm::mat4 projection =
@@ -172,20 +907,112 @@ void Thread::run()
                            glm::vec3(0.0f, 0.0f, -5.0f));
 
         // Clear the color buffer
-        glViewport(0, 0, w, h);
-        glClearColor(0.0f, 0.0f, 0.2f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
+        trace.viewport(0, 0, renderWidth, renderHeight);
+        trace.clearColor(0.0f, 0.0f, 0.2f, 1.0f);
+        trace.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        trace.enable(GL_DEPTH_TEST);
+        trace.disable(GL_CULL_FACE);
+
+        // Render the scene
+        const int elapsed = timer.elapsed();
+        scene.update(animating ? float(elapsed) : 0.0f);
+        renderScene(scene, meshes, projection * view);
+
+        // Resolve the multisampled scene. Resolve must be done with
+        // the same size so the scaling is done after it.
+        Framebuffer::Ptr source = sceneFramebuffer;
+        if (msaa)
+        {
+            sceneFramebuffer->blit(resolveFramebuffer->id(),
+                                   renderWidth, renderHeight,
+                                   GL_NEAREST);
+            source = resolveFramebuffer;
+        }
+
+        // Post-process or upscale into the surface. FXAA samples the
+        // texture with a linear filter so it does the upscale too.
+        if (offscreen && postProcess)
+        {
+            trace.bindFramebuffer(GL_FRAMEBUFFER, 0);
+            trace.viewport(0, 0, w, h);
+            fxaa->render(source->colorTexture(),
+                         source->width(),
+                         source->height());
+        }
+        else if (offscreen)
+        {
+            source->blit(0, w, h, GL_LINEAR);
+        }
 
-        // Render the quad
-        quad->update(timer.elapsed());
-        quad->render(view, projection);
+        gpuTimer->end();
+
+        // Feed the GPU time into statistics and scale controller.
+        double gpuTime = 0.0;
+        while (gpuTimer->result(gpuTime))
+        {
+            stats->addGpuTime(gpuTime);
+            if (adaptive)
+                scaler.update(gpuTime);
+        }
+
+        stats->setResolution(adaptive,
+                             scaler.scale(),
+                             scaler.budgetHitRate());
+        d->mutex.lock();
+        d->resolutionScale = adaptive ? scaler.scale() : 1.0;
+        d->budgetHitRate   = scaler.budgetHitRate();
+        d->mutex.unlock();
 
         // Swap buffers and we're done.
-        widget->swapBuffers();
-        widget->doneCurrent();
+        stats->beginPresent();
+        surface->swapBuffers();
+        stats->endPresent();
+        trace.endFrame();
+
+        // Fence the frame and collect the finished frame latencies.
+        limiter.endFrame();
+        double latency = 0.0;
+        while (limiter.latency(latency))
+            stats->addLatency(latency);
+        stats->addSyncCalls(debug.takeSyncCalls());
+
+        // The first frame of the scene finishes the startup.
+        if (!sceneLoaded)
+        {
+            sceneLoaded = true;
+            startup.mark("loaded");
+            startup.finish();
+        }
+
+        surface->doneCurrent();
     }
+
+    // Release the OpenGL resources while the context is current.
+    Surface::Ptr surface = d->openglSurface.lock();
+    if (surface && d->initialized)
+    {
+        surface->makeCurrent();
+        limiter.clear();
+        sceneFramebuffer.reset();
+        resolveFramebuffer.reset();
+        fxaa.reset();
+        gpuTimer.reset();
+        meshes.clear();
+        surface->doneCurrent();
+        d->initialized = false;
+        trace.stop();
+
+        // Everything is released so anything live has leaked.
+        const int leaks = ResourceRegistry::instance().reportLeaks();
+        if (leaks > 0)
+            std::cerr << leaks << " OpenGL objects leaked"
+                      << std::endl;
+    }
+
+    // Give the context back to the UI thread so that the thread can
+    // be started again and the context is destroyed in its thread.
+    if (surface)
+        surface->releaseContext();
 }
 
 } // namespace opengl
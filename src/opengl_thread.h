@@ -6,23 +6,54 @@
 #pragma once
 
 #include <QtCore/QThread>
-#include "opengl_widget.h"
+#include "opengl_surface.h"
 
 namespace kuu
 {
 namespace opengl
 {
 
-class Widget;
-
 /* ---------------------------------------------------------------- *
    A thread class for OpenGL multi-thread rendering. This thread
-   uses the context of the OpenGL widget that is given in during
+   uses the context of the OpenGL surface that is given in during
    construction. The rendering result will be displayed on the
-   widget's surface.
+   surface. The surface is either a kuu::opengl::Widget or a kuu::
+   opengl::Window.
 
    The thread is stopped when user calls stop() or the given in
-   widget pointer goes to nullptr.
+   surface pointer goes to nullptr.
+
+   The average frame time and present latency (the time spent in
+   the buffer swap) are printed into standard output once a second.
+
+   If a target frame time is set then the scene is rendered into an
+   offscreen framebuffer whose resolution is scaled down when the
+   GPU time goes over the target. The framebuffer is upscaled into
+   the surface with a linear filter.
+
+   The CPU is not allowed to run more than the set count of frames
+   ahead of the GPU. Each frame is fenced after the buffer swap and
+   the oldest fence is waited when the limit is reached.
+
+   The anti-aliasing is either off, MSAA or FXAA. MSAA renders the
+   scene into a multisampled framebuffer that is resolved with a
+   blit. FXAA renders the scene into a single sampled framebuffer
+   and filters the edges in a post-process pass.
+
+   In on-demand mode the thread sleeps until the scene is animated,
+   resized or marked dirty with requestRender(). The thread sleeps
+   also while it is paused, e.g. while the surface is hidden.
+
+   The OpenGL commands of the frames are issued through the kuu::
+   opengl::Trace so that the frames can be recorded when the trace
+   is recording. The KHR_debug output is installed when the context
+   is created, see kuu::opengl::Debug, and the calls that force the
+   CPU to wait for the driver are reported per frame.
+
+   The first frame is only cleared so that it is presented as soon
+   as the context is current. The scene is created after it from
+   the assets prepared by kuu::opengl::Startup on worker threads,
+   the shader programs are linked in a shared context if possible.
 
    The rendering is a simple rotating quad where shading is done
    with the vertex colors.
@@ -33,12 +64,61 @@ public:
     // Defines a shared pointer of thread.
     using Ptr = std::shared_ptr<Thread>;
 
-    // Constructs the thread from the widget.
-    Thread(Widget::WeakPtr openGLWidget);
+    // Anti-aliasing modes.
+    enum class AntiAliasing
+    {
+        Off,  // no anti-aliasing
+        Msaa, // multisampling with explicit resolve
+        Fxaa  // FXAA post-process
+    };
+
+    // The settings that the thread starts with. They can be changed
+    // with the setters below while the thread is running.
+    struct Settings
+    {
+        double targetFrameTime = 0.0; // milliseconds, 0 to disable
+        int maxFramesInFlight = 2;    // from 1 to 3
+        bool onDemand = false;        // true if rendering on-demand
+        AntiAliasing antiAliasing = AntiAliasing::Msaa;
+        int samples = 4;              // sample count of MSAA
+    };
+
+    // Constructs the thread from the surface and the settings.
+    Thread(Surface::WeakPtr openglSurface);
+    Thread(Surface::WeakPtr openglSurface, const Settings& settings);
 
     // Sets the viewport size
     void setViewportSize(int width, int height);
 
+    // Sets the on-demand rendering on or off.
+    void setOnDemand(bool onDemand);
+    // Marks the scene dirty so that a frame is rendered.
+    void requestRender();
+    // Sets the scene animation on or off.
+    void setAnimating(bool animating);
+    // Returns true if the scene is animated.
+    bool isAnimating() const;
+    // Pauses the rendering while the surface is not visible.
+    void setPaused(bool paused);
+
+    // Sets the anti-aliasing mode. The sample count is used by the
+    // MSAA mode.
+    void setAntiAliasing(AntiAliasing mode, int samples = 4);
+    // Switches into the next anti-aliasing mode.
+    void cycleAntiAliasing();
+
+    // Sets the target frame time of the adaptive resolution in
+    // milliseconds, zero disables the adaptive resolution.
+    void setTargetFrameTime(double milliseconds);
+
+    // Sets the maximum count of frames in-flight, from 1 to 3.
+    void setMaxFramesInFlight(int frames);
+
+    // Returns the current resolution scale.
+    double resolutionScale() const;
+    // Returns the ratio of recent frames that fit into the target.
+    double budgetHitRate() const;
+
     // Starts the rendering thread.
     void start();
 
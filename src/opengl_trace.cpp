@@ -0,0 +1,1233 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::Trace and
+           kuu::opengl::TracePlayer classes.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_trace.h"
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "opengl_debug.h"
+#include "opengl_framebuffer.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+namespace
+{
+
+const char Magic[8] = { 'K', 'U', 'U', 'T', 'R', 'A', 'C', 'E' };
+const std::uint32_t Version = 1;
+
+// Returns the bits of the float.
+std::uint32_t bits(float value)
+{
+    std::uint32_t result = 0;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+// Returns the float of the bits.
+float fromBits(std::uint32_t value)
+{
+    float result = 0.0f;
+    std::memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the size of the texel data in bytes. The rows are aligned
+   into 4 bytes which is the default unpack alignment.
+ * ---------------------------------------------------------------- */
+std::uint32_t imageSize(GLsizei width, GLsizei height,
+                        GLenum format, GLenum type)
+{
+    int components = 4;
+    switch (format)
+    {
+        case GL_RED:             components = 1; break;
+        case GL_DEPTH_COMPONENT: components = 1; break;
+        case GL_RG:              components = 2; break;
+        case GL_RGB:             components = 3; break;
+        default:                 components = 4; break;
+    }
+
+    int componentSize = 1;
+    switch (type)
+    {
+        case GL_UNSIGNED_SHORT: componentSize = 2; break;
+        case GL_HALF_FLOAT:     componentSize = 2; break;
+        case GL_FLOAT:          componentSize = 4; break;
+        case GL_UNSIGNED_INT:   componentSize = 4; break;
+        default:                componentSize = 1; break;
+    }
+
+    const std::uint32_t rowSize =
+        (std::uint32_t(width * components * componentSize) + 3u) & ~3u;
+    return rowSize * std::uint32_t(height);
+}
+
+} // anonymous namespace
+
+/* ---------------------------------------------------------------- *
+   The data of the trace.
+ * ---------------------------------------------------------------- */
+struct Trace::Data
+{
+    // Writes the command and its arguments.
+    void record(Command command,
+                std::initializer_list<std::uint32_t> args)
+    { record(command, args, 0, 0); }
+
+    // Writes the command, its arguments and the data with a size
+    // prefix. The data is not written if it is null.
+    void record(Command command,
+                std::initializer_list<std::uint32_t> args,
+                const void* data,
+                std::uint32_t size)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        write(command, args, data, size);
+    }
+
+    // Writes the command into the file if it is open. The mutex must
+    // be locked.
+    void write(Command command,
+               std::initializer_list<std::uint32_t> args,
+               const void* data,
+               std::uint32_t size)
+    {
+        if (!file.is_open())
+            return;
+
+        const std::uint8_t code = std::uint8_t(command);
+        file.write(reinterpret_cast<const char*>(&code), 1);
+        for (std::uint32_t arg : args)
+            file.write(reinterpret_cast<const char*>(&arg), 4);
+
+        if (data)
+        {
+            file.write(reinterpret_cast<const char*>(&size), 4);
+            file.write(static_cast<const char*>(data), size);
+        }
+    }
+
+    // Closes the file. The mutex must be locked.
+    void close()
+    {
+        if (!file.is_open())
+            return;
+
+        recording = false;
+        file.close();
+        std::cout << "Recorded " << frames << " frames into "
+                  << filePath << std::endl;
+    }
+
+    std::mutex mutex;              // guards the file and counts
+    std::ofstream file;            // trace file
+    std::string filePath;          // path of the trace file
+    std::atomic<bool> recording;   // true if recording
+    int frameCount = 0;            // count of frames to record
+    int frames     = 0;            // count of recorded frames
+};
+
+/* ---------------------------------------------------------------- *
+   Returns the trace of the process.
+ * ---------------------------------------------------------------- */
+Trace& Trace::instance()
+{
+    static Trace trace;
+    return trace;
+}
+
+/* ---------------------------------------------------------------- *
+   Constructs the trace.
+ * ---------------------------------------------------------------- */
+Trace::Trace()
+    : d(std::make_shared<Data>())
+{
+    d->recording = false;
+}
+
+/* ---------------------------------------------------------------- *
+   Starts recording. The header is written into the file.
+ * ---------------------------------------------------------------- */
+bool Trace::start(const std::string& filePath, int frameCount)
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    if (d->file.is_open())
+        d->file.close();
+
+    d->file.open(filePath, std::ios::out | std::ios::binary);
+    if (!d->file.is_open())
+    {
+        std::cerr << "Failed to open trace file " << filePath
+                  << std::endl;
+        return false;
+    }
+
+    d->file.write(Magic, sizeof(Magic));
+    d->file.write(reinterpret_cast<const char*>(&Version), 4);
+
+    d->filePath   = filePath;
+    d->frameCount = frameCount;
+    d->frames     = 0;
+    d->recording  = true;
+    return true;
+}
+
+/* ---------------------------------------------------------------- *
+   Stops recording.
+ * ---------------------------------------------------------------- */
+void Trace::stop()
+{
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->close();
+}
+
+/* ---------------------------------------------------------------- *
+   Returns true if recording.
+ * ---------------------------------------------------------------- */
+bool Trace::isRecording() const
+{ return d->recording; }
+
+/* ---------------------------------------------------------------- *
+   Frames. The recording is stopped after the last frame.
+ * ---------------------------------------------------------------- */
+void Trace::beginFrame(int width, int height)
+{
+    if (d->recording)
+        d->record(Command::BeginFrame,
+                  { std::uint32_t(width), std::uint32_t(height) });
+}
+
+void Trace::endFrame()
+{
+    if (!d->recording)
+        return;
+
+    // The count is updated under the same lock as the file so that
+    // a command recorded from another thread does not race the stop.
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->write(Command::EndFrame, {}, 0, 0);
+    d->frames++;
+    if (d->frameCount > 0 && d->frames >= d->frameCount)
+        d->close();
+}
+
+/* ---------------------------------------------------------------- *
+   Objects.
+ * ---------------------------------------------------------------- */
+void Trace::recordCreate(ResourceRegistry::Category category,
+                         GLuint name,
+                         GLenum type,
+                         const std::string& label)
+{
+    if (d->recording && name != 0)
+        d->record(Command::CreateObject,
+                  { std::uint32_t(category), name, type },
+                  label.c_str(), std::uint32_t(label.size()));
+}
+
+void Trace::recordDelete(ResourceRegistry::Category category,
+                         GLuint name)
+{
+    if (d->recording && name != 0)
+        d->record(Command::DeleteObject,
+                  { std::uint32_t(category), name });
+}
+
+/* ---------------------------------------------------------------- *
+   Data stores.
+ * ---------------------------------------------------------------- */
+void Trace::bufferData(GLuint buffer, GLenum target, GLsizeiptr size,
+                       const void* data, GLenum usage)
+{
+    glBufferData(target, size, data, usage);
+    if (d->recording)
+        d->record(Command::BufferData,
+                  { buffer, target, std::uint32_t(size), usage,
+                    data ? 1u : 0u },
+                  data, std::uint32_t(size));
+}
+
+void Trace::texImage2D(GLuint texture, GLint internalFormat,
+                       GLsizei width, GLsizei height,
+                       GLenum format, GLenum type, const void* data)
+{
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0,
+                 format, type, data);
+    if (d->recording)
+        d->record(Command::TexImage2D,
+                  { texture, std::uint32_t(internalFormat),
+                    std::uint32_t(width), std::uint32_t(height),
+                    format, type, data ? 1u : 0u },
+                  data, imageSize(width, height, format, type));
+}
+
+void Trace::renderbufferStorage(GLuint renderbuffer, GLsizei samples,
+                                GLenum internalFormat,
+                                GLsizei width, GLsizei height)
+{
+    if (samples > 0)
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+                                         internalFormat,
+                                         width, height);
+    else
+        glRenderbufferStorage(GL_RENDERBUFFER, internalFormat,
+                              width, height);
+
+    if (d->recording)
+        d->record(Command::RenderbufferStorage,
+                  { renderbuffer, std::uint32_t(samples),
+                    internalFormat,
+                    std::uint32_t(width), std::uint32_t(height) });
+}
+
+/* ---------------------------------------------------------------- *
+   Bindings.
+ * ---------------------------------------------------------------- */
+void Trace::bindVertexArray(GLuint vertexArray)
+{
+    glBindVertexArray(vertexArray);
+    Debug::instance().bound(ResourceRegistry::VertexArray, vertexArray);
+    if (d->recording)
+        d->record(Command::BindVertexArray, { vertexArray });
+}
+
+void Trace::bindBuffer(GLenum target, GLuint buffer)
+{
+    glBindBuffer(target, buffer);
+    Debug::instance().bound(ResourceRegistry::Buffer, buffer);
+    if (d->recording)
+        d->record(Command::BindBuffer, { target, buffer });
+}
+
+void Trace::bindTexture(GLenum target, GLuint texture)
+{
+    glBindTexture(target, texture);
+    Debug::instance().bound(ResourceRegistry::Texture, texture);
+    if (d->recording)
+        d->record(Command::BindTexture, { target, texture });
+}
+
+void Trace::bindRenderbuffer(GLuint renderbuffer)
+{
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    Debug::instance().bound(ResourceRegistry::Renderbuffer, renderbuffer);
+    if (d->recording)
+        d->record(Command::BindRenderbuffer, { renderbuffer });
+}
+
+void Trace::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    glBindFramebuffer(target, framebuffer);
+    Debug::instance().bound(ResourceRegistry::Framebuffer, framebuffer);
+    if (d->recording)
+        d->record(Command::BindFramebuffer, { target, framebuffer });
+}
+
+void Trace::useProgram(GLuint program)
+{
+    glUseProgram(program);
+    if (d->recording)
+        d->record(Command::UseProgram, { program });
+}
+
+void Trace::activeTexture(GLenum unit)
+{
+    glActiveTexture(unit);
+    if (d->recording)
+        d->record(Command::ActiveTexture, { unit });
+}
+
+/* ---------------------------------------------------------------- *
+   Texture parameters and framebuffer attachments.
+ * ---------------------------------------------------------------- */
+void Trace::texParameteri(GLenum target, GLenum name, GLint param)
+{
+    glTexParameteri(target, name, param);
+    if (d->recording)
+        d->record(Command::TexParameteri,
+                  { target, name, std::uint32_t(param) });
+}
+
+void Trace::framebufferTexture2D(GLenum target, GLenum attachment,
+                                 GLenum textureTarget, GLuint texture,
+                                 GLint level)
+{
+    glFramebufferTexture2D(target, attachment, textureTarget,
+                           texture, level);
+    if (d->recording)
+        d->record(Command::FramebufferTexture2D,
+                  { target, attachment, textureTarget, texture,
+                    std::uint32_t(level) });
+}
+
+void Trace::framebufferRenderbuffer(GLenum target, GLenum attachment,
+                                    GLenum renderbufferTarget,
+                                    GLuint renderbuffer)
+{
+    glFramebufferRenderbuffer(target, attachment,
+                              renderbufferTarget, renderbuffer);
+    if (d->recording)
+        d->record(Command::FramebufferRenderbuffer,
+                  { target, attachment, renderbufferTarget,
+                    renderbuffer });
+}
+
+void Trace::blitFramebuffer(GLint srcX0, GLint srcY0,
+                            GLint srcX1, GLint srcY1,
+                            GLint dstX0, GLint dstY0,
+                            GLint dstX1, GLint dstY1,
+                            GLbitfield mask, GLenum filter)
+{
+    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1,
+                      dstX0, dstY0, dstX1, dstY1,
+                      mask, filter);
+    if (d->recording)
+        d->record(Command::BlitFramebuffer,
+                  { std::uint32_t(srcX0), std::uint32_t(srcY0),
+                    std::uint32_t(srcX1), std::uint32_t(srcY1),
+                    std::uint32_t(dstX0), std::uint32_t(dstY0),
+                    std::uint32_t(dstX1), std::uint32_t(dstY1),
+                    mask, filter });
+}
+
+/* ---------------------------------------------------------------- *
+   Vertex attributes.
+ * ---------------------------------------------------------------- */
+void Trace::enableVertexAttribArray(GLuint index)
+{
+    glEnableVertexAttribArray(index);
+    if (d->recording)
+        d->record(Command::EnableVertexAttribArray, { index });
+}
+
+void Trace::vertexAttribPointer(GLuint index, GLint size, GLenum type,
+                                GLboolean normalized, GLsizei stride,
+                                GLsizeiptr offset)
+{
+    glVertexAttribPointer(index, size, type, normalized, stride,
+                          (const GLvoid*) offset);
+    if (d->recording)
+        d->record(Command::VertexAttribPointer,
+                  { index, std::uint32_t(size), type,
+                    std::uint32_t(normalized),
+                    std::uint32_t(stride), std::uint32_t(offset) });
+}
+
+/* ---------------------------------------------------------------- *
+   Shaders and programs.
+ * ---------------------------------------------------------------- */
+void Trace::shaderSource(GLuint shader, const std::string& source)
+{
+    const char* sourcePtr = source.c_str();
+    glShaderSource(shader, 1, &sourcePtr, 0);
+    if (d->recording)
+        d->record(Command::ShaderSource, { shader },
+                  source.c_str(), std::uint32_t(source.size()));
+}
+
+void Trace::compileShader(GLuint shader)
+{
+    glCompileShader(shader);
+    if (d->recording)
+        d->record(Command::CompileShader, { shader });
+}
+
+void Trace::attachShader(GLuint program, GLuint shader)
+{
+    glAttachShader(program, shader);
+    if (d->recording)
+        d->record(Command::AttachShader, { program, shader });
+}
+
+void Trace::linkProgram(GLuint program)
+{
+    glLinkProgram(program);
+    if (d->recording)
+        d->record(Command::LinkProgram, { program });
+}
+
+GLint Trace::uniformLocation(GLuint program, const std::string& name)
+{
+    const GLint location = glGetUniformLocation(program, name.c_str());
+    Debug::instance().countSyncCall();
+    if (d->recording)
+        d->record(Command::UniformLocation,
+                  { program, std::uint32_t(location) },
+                  name.c_str(), std::uint32_t(name.size()));
+    return location;
+}
+
+/* ---------------------------------------------------------------- *
+   Uniforms.
+ * ---------------------------------------------------------------- */
+void Trace::uniform1i(GLint location, GLint value)
+{
+    glUniform1i(location, value);
+    if (d->recording)
+        d->record(Command::Uniform1i,
+                  { std::uint32_t(location), std::uint32_t(value) });
+}
+
+void Trace::uniform2f(GLint location, GLfloat x, GLfloat y)
+{
+    glUniform2f(location, x, y);
+    if (d->recording)
+        d->record(Command::Uniform2f,
+                  { std::uint32_t(location), bits(x), bits(y) });
+}
+
+void Trace::uniformMatrix4fv(GLint location, const GLfloat* matrix)
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
+    if (d->recording)
+        d->record(Command::UniformMatrix4fv,
+                  { std::uint32_t(location) },
+                  matrix, 16 * sizeof(GLfloat));
+}
+
+/* ---------------------------------------------------------------- *
+   State and drawing.
+ * ---------------------------------------------------------------- */
+void Trace::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    glViewport(x, y, width, height);
+    if (d->recording)
+        d->record(Command::Viewport,
+                  { std::uint32_t(x), std::uint32_t(y),
+                    std::uint32_t(width), std::uint32_t(height) });
+}
+
+void Trace::clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+    glClearColor(r, g, b, a);
+    if (d->recording)
+        d->record(Command::ClearColor,
+                  { bits(r), bits(g), bits(b), bits(a) });
+}
+
+void Trace::clear(GLbitfield mask)
+{
+    glClear(mask);
+    if (d->recording)
+        d->record(Command::Clear, { mask });
+}
+
+void Trace::enable(GLenum capability)
+{
+    glEnable(capability);
+    if (d->recording)
+        d->record(Command::Enable, { capability });
+}
+
+void Trace::disable(GLenum capability)
+{
+    glDisable(capability);
+    if (d->recording)
+        d->record(Command::Disable, { capability });
+}
+
+void Trace::drawElements(GLenum mode, GLsizei count, GLenum type,
+                         GLsizeiptr offset)
+{
+    glDrawElements(mode, count, type, (const GLvoid*) offset);
+    if (d->recording)
+        d->record(Command::DrawElements,
+                  { mode, std::uint32_t(count), type,
+                    std::uint32_t(offset) });
+}
+
+void Trace::drawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    glDrawArrays(mode, first, count);
+    if (d->recording)
+        d->record(Command::DrawArrays,
+                  { mode, std::uint32_t(first),
+                    std::uint32_t(count) });
+}
+
+/* ---------------------------------------------------------------- *
+   The data of the trace player. The recorded names are mapped into
+   the names of the player per category. The uniform locations are
+   mapped per recorded program.
+ * ---------------------------------------------------------------- */
+struct TracePlayer::Data
+{
+    using Category = ResourceRegistry::Category;
+    using Command  = Trace::Command;
+
+    // Destroys the player data. The objects still live are deleted.
+    ~Data()
+    {
+        for (int c = 0; c < ResourceRegistry::CategoryCount; ++c)
+            for (const auto& name : names[c])
+                deleteObject(Category(c), name.second);
+        defaultFramebuffer.reset();
+    }
+
+    // Returns the next argument. If the trace ends then the trace
+    // is marked as corrupted and zero is returned.
+    std::uint32_t next()
+    {
+        std::uint32_t value = 0;
+        if (position + 4 > bytes.size())
+        {
+            corrupted = true;
+            return value;
+        }
+        std::memcpy(&value, &bytes[position], 4);
+        position += 4;
+        return value;
+    }
+
+    // Returns the next data with size prefix. The size is written
+    // into the argument.
+    const char* nextData(std::uint32_t& size)
+    {
+        size = next();
+        if (corrupted || position + size > bytes.size())
+        {
+            corrupted = true;
+            size = 0;
+            return 0;
+        }
+        const char* data = &bytes[position];
+        position += size;
+        return data;
+    }
+
+    // Returns the next string with size prefix.
+    std::string nextString()
+    {
+        std::uint32_t size = 0;
+        const char* data = nextData(size);
+        return data ? std::string(data, size) : std::string();
+    }
+
+    // Maps the recorded object name into the name of the player. The
+    // default framebuffer is mapped into the offscreen target.
+    GLuint map(Category category, GLuint name) const
+    {
+        if (name == 0)
+        {
+            if (category == ResourceRegistry::Framebuffer &&
+                defaultFramebuffer)
+            {
+                return defaultFramebuffer->id();
+            }
+            return 0;
+        }
+
+        const auto it = names[category].find(name);
+        if (it == names[category].end())
+            return 0;
+        return it->second;
+    }
+
+    // Maps the recorded uniform location of the program in use.
+    GLint mapLocation(GLint location) const
+    {
+        const auto it = locations.find(Location(program, location));
+        if (it == locations.end())
+            return -1;
+        return it->second;
+    }
+
+    // Creates an object through the resource registry.
+    GLuint createObject(Category category,
+                        GLenum type,
+                        const std::string& label)
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        switch (category)
+        {
+            case ResourceRegistry::Buffer:
+                return registry.createBuffer(label);
+            case ResourceRegistry::VertexArray:
+                return registry.createVertexArray(label);
+            case ResourceRegistry::Texture:
+                return registry.createTexture(label);
+            case ResourceRegistry::Renderbuffer:
+                return registry.createRenderbuffer(label);
+            case ResourceRegistry::Framebuffer:
+                return registry.createFramebuffer(label);
+            case ResourceRegistry::Shader:
+                return registry.createShader(type, label);
+            case ResourceRegistry::Program:
+                return registry.createProgram(label);
+            case ResourceRegistry::Query:
+                return registry.createQuery(label);
+            default:
+                return 0;
+        }
+    }
+
+    // Deletes an object through the resource registry.
+    void deleteObject(Category category, GLuint name)
+    {
+        ResourceRegistry& registry = ResourceRegistry::instance();
+        switch (category)
+        {
+            case ResourceRegistry::Buffer:
+                registry.deleteBuffer(name); break;
+            case ResourceRegistry::VertexArray:
+                registry.deleteVertexArray(name); break;
+            case ResourceRegistry::Texture:
+                registry.deleteTexture(name); break;
+            case ResourceRegistry::Renderbuffer:
+                registry.deleteRenderbuffer(name); break;
+            case ResourceRegistry::Framebuffer:
+                registry.deleteFramebuffer(name); break;
+            case ResourceRegistry::Shader:
+                registry.deleteShader(name); break;
+            case ResourceRegistry::Program:
+                registry.deleteProgram(name); break;
+            case ResourceRegistry::Query:
+                registry.deleteQuery(name); break;
+            default:
+                break;
+        }
+    }
+
+    // Plays a single command. Returns false if the command is not
+    // known.
+    bool play(Command command);
+
+    // Key of a uniform location, the recorded program and location.
+    using Location = std::pair<GLuint, GLint>;
+
+    std::vector<char> bytes;     // contents of the trace file
+    std::size_t position = 0;    // position of the next command
+    bool valid     = false;      // true if the file was read
+    bool corrupted = false;      // true if the trace is corrupted
+
+    std::map<GLuint, GLuint> names[ResourceRegistry::CategoryCount];
+    std::map<Location, GLint> locations;
+    GLuint program = 0;          // recorded program in use
+
+    Framebuffer::Ptr defaultFramebuffer; // offscreen target
+    int width  = 0;              // width of the last frame
+    int height = 0;              // height of the last frame
+};
+
+/* ---------------------------------------------------------------- *
+   Plays a single command. The arguments are read in the order they
+   were recorded. All the arguments are read before the OpenGL call
+   so that a command that runs off the end of the trace is rejected
+   without calling OpenGL.
+ * ---------------------------------------------------------------- */
+bool TracePlayer::Data::play(Command command)
+{
+    ResourceRegistry& registry = ResourceRegistry::instance();
+
+    switch (command)
+    {
+        case Command::BeginFrame:
+        {
+            const int w = int(next());
+            const int h = int(next());
+            if (corrupted)
+                return false;
+            width  = w;
+            height = h;
+            if (!defaultFramebuffer)
+                defaultFramebuffer =
+                    std::make_shared<Framebuffer>(width, height);
+            else
+                defaultFramebuffer->resize(width, height);
+            defaultFramebuffer->bind();
+            break;
+        }
+
+        case Command::EndFrame:
+            break;
+
+        case Command::CreateObject:
+        {
+            const Category category = Category(next());
+            const GLuint name = next();
+            const GLenum type = next();
+            const std::string label = nextString();
+            if (corrupted || category >= ResourceRegistry::CategoryCount)
+                return false;
+            names[category][name] = createObject(category, type, label);
+            break;
+        }
+
+        case Command::DeleteObject:
+        {
+            const Category category = Category(next());
+            const GLuint name = next();
+            if (corrupted || category >= ResourceRegistry::CategoryCount)
+                return false;
+            const auto it = names[category].find(name);
+            if (it != names[category].end())
+            {
+                deleteObject(category, it->second);
+                names[category].erase(it);
+            }
+            break;
+        }
+
+        case Command::BufferData:
+        {
+            const GLuint buffer  = map(ResourceRegistry::Buffer, next());
+            const GLenum target  = next();
+            const GLsizeiptr size = next();
+            const GLenum usage   = next();
+            const bool hasData   = next() != 0;
+            std::uint32_t dataSize = 0;
+            const char* data = hasData ? nextData(dataSize) : 0;
+            if (corrupted)
+                return false;
+            if (hasData && dataSize != std::uint32_t(size))
+                return false;
+            registry.bufferData(buffer, target, size, data, usage);
+            break;
+        }
+
+        case Command::TexImage2D:
+        {
+            const GLuint texture = map(ResourceRegistry::Texture, next());
+            const GLint internalFormat = GLint(next());
+            const GLsizei w = GLsizei(next());
+            const GLsizei h = GLsizei(next());
+            const GLenum format = next();
+            const GLenum type   = next();
+            const bool hasData  = next() != 0;
+            std::uint32_t dataSize = 0;
+            const char* data = hasData ? nextData(dataSize) : 0;
+            if (corrupted)
+                return false;
+            if (hasData && dataSize != imageSize(w, h, format, type))
+                return false;
+            registry.textureImage2D(texture, internalFormat, w, h,
+                                    format, type, data);
+            break;
+        }
+
+        case Command::RenderbufferStorage:
+        {
+            const GLuint renderbuffer =
+                map(ResourceRegistry::Renderbuffer, next());
+            const GLsizei samples = GLsizei(next());
+            const GLenum internalFormat = next();
+            const GLsizei w = GLsizei(next());
+            const GLsizei h = GLsizei(next());
+            if (corrupted)
+                return false;
+            registry.renderbufferStorage(renderbuffer, samples,
+                                         internalFormat, w, h);
+            break;
+        }
+
+        case Command::BindVertexArray:
+        {
+            const GLuint vertexArray =
+                map(ResourceRegistry::VertexArray, next());
+            if (corrupted)
+                return false;
+            glBindVertexArray(vertexArray);
+            break;
+        }
+
+        case Command::BindBuffer:
+        {
+            const GLenum target = next();
+            const GLuint buffer = map(ResourceRegistry::Buffer, next());
+            if (corrupted)
+                return false;
+            glBindBuffer(target, buffer);
+            break;
+        }
+
+        case Command::BindTexture:
+        {
+            const GLenum target  = next();
+            const GLuint texture = map(ResourceRegistry::Texture, next());
+            if (corrupted)
+                return false;
+            glBindTexture(target, texture);
+            break;
+        }
+
+        case Command::BindRenderbuffer:
+        {
+            const GLuint renderbuffer =
+                map(ResourceRegistry::Renderbuffer, next());
+            if (corrupted)
+                return false;
+            glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+            break;
+        }
+
+        case Command::BindFramebuffer:
+        {
+            const GLenum target = next();
+            const GLuint framebuffer =
+                map(ResourceRegistry::Framebuffer, next());
+            if (corrupted)
+                return false;
+            glBindFramebuffer(target, framebuffer);
+            break;
+        }
+
+        case Command::UseProgram:
+        {
+            const GLuint recorded = next();
+            if (corrupted)
+                return false;
+            program = recorded;
+            glUseProgram(map(ResourceRegistry::Program, program));
+            break;
+        }
+
+        case Command::ActiveTexture:
+        {
+            const GLenum unit = next();
+            if (corrupted)
+                return false;
+            glActiveTexture(unit);
+            break;
+        }
+
+        case Command::TexParameteri:
+        {
+            const GLenum target = next();
+            const GLenum name   = next();
+            const GLint value   = GLint(next());
+            if (corrupted)
+                return false;
+            glTexParameteri(target, name, value);
+            break;
+        }
+
+        case Command::FramebufferTexture2D:
+        {
+            const GLenum target        = next();
+            const GLenum attachment    = next();
+            const GLenum textureTarget = next();
+            const GLuint texture = map(ResourceRegistry::Texture, next());
+            const GLint level          = GLint(next());
+            if (corrupted)
+                return false;
+            glFramebufferTexture2D(target, attachment, textureTarget,
+                                   texture, level);
+            break;
+        }
+
+        case Command::FramebufferRenderbuffer:
+        {
+            const GLenum target             = next();
+            const GLenum attachment         = next();
+            const GLenum renderbufferTarget = next();
+            const GLuint renderbuffer =
+                map(ResourceRegistry::Renderbuffer, next());
+            if (corrupted)
+                return false;
+            glFramebufferRenderbuffer(target, attachment,
+                                      renderbufferTarget, renderbuffer);
+            break;
+        }
+
+        case Command::BlitFramebuffer:
+        {
+            GLint coords[8];
+            for (GLint& coord : coords)
+                coord = GLint(next());
+            const GLbitfield mask = next();
+            const GLenum filter   = next();
+            if (corrupted)
+                return false;
+            glBlitFramebuffer(coords[0], coords[1], coords[2], coords[3],
+                              coords[4], coords[5], coords[6], coords[7],
+                              mask, filter);
+            break;
+        }
+
+        case Command::EnableVertexAttribArray:
+        {
+            const GLuint index = next();
+            if (corrupted)
+                return false;
+            glEnableVertexAttribArray(index);
+            break;
+        }
+
+        case Command::VertexAttribPointer:
+        {
+            const GLuint index  = next();
+            const GLint size    = GLint(next());
+            const GLenum type   = next();
+            const GLboolean normalized = GLboolean(next());
+            const GLsizei stride = GLsizei(next());
+            const GLsizeiptr offset = next();
+            if (corrupted)
+                return false;
+            glVertexAttribPointer(index, size, type, normalized, stride,
+                                  (const GLvoid*) offset);
+            break;
+        }
+
+        case Command::ShaderSource:
+        {
+            const GLuint shader = map(ResourceRegistry::Shader, next());
+            const std::string source = nextString();
+            if (corrupted)
+                return false;
+            const char* sourcePtr = source.c_str();
+            glShaderSource(shader, 1, &sourcePtr, 0);
+            break;
+        }
+
+        case Command::CompileShader:
+        {
+            const GLuint shader = map(ResourceRegistry::Shader, next());
+            if (corrupted)
+                return false;
+            glCompileShader(shader);
+            break;
+        }
+
+        case Command::AttachShader:
+        {
+            const GLuint program = map(ResourceRegistry::Program, next());
+            const GLuint shader  = map(ResourceRegistry::Shader, next());
+            if (corrupted)
+                return false;
+            glAttachShader(program, shader);
+            break;
+        }
+
+        case Command::LinkProgram:
+        {
+            const GLuint program = map(ResourceRegistry::Program, next());
+            if (corrupted)
+                return false;
+            glLinkProgram(program);
+            break;
+        }
+
+        case Command::UniformLocation:
+        {
+            const GLuint program  = next();
+            const GLint location  = GLint(next());
+            const std::string name = nextString();
+            if (corrupted)
+                return false;
+            locations[Location(program, location)] =
+                glGetUniformLocation(map(ResourceRegistry::Program,
+                                         program),
+                                     name.c_str());
+            break;
+        }
+
+        case Command::Uniform1i:
+        {
+            const GLint location = mapLocation(GLint(next()));
+            const GLint value    = GLint(next());
+            if (corrupted)
+                return false;
+            glUniform1i(location, value);
+            break;
+        }
+
+        case Command::Uniform2f:
+        {
+            const GLint location = mapLocation(GLint(next()));
+            const float x = fromBits(next());
+            const float y = fromBits(next());
+            if (corrupted)
+                return false;
+            glUniform2f(location, x, y);
+            break;
+        }
+
+        case Command::UniformMatrix4fv:
+        {
+            const GLint location = mapLocation(GLint(next()));
+            std::uint32_t size = 0;
+            const char* data = nextData(size);
+            if (corrupted || size != 16 * sizeof(GLfloat))
+                return false;
+            GLfloat matrix[16];
+            std::memcpy(matrix, data, sizeof(matrix));
+            glUniformMatrix4fv(location, 1, GL_FALSE, matrix);
+            break;
+        }
+
+        case Command::Viewport:
+        {
+            const GLint x = GLint(next());
+            const GLint y = GLint(next());
+            const GLsizei w = GLsizei(next());
+            const GLsizei h = GLsizei(next());
+            if (corrupted)
+                return false;
+            glViewport(x, y, w, h);
+            break;
+        }
+
+        case Command::ClearColor:
+        {
+            const float r = fromBits(next());
+            const float g = fromBits(next());
+            const float b = fromBits(next());
+            const float a = fromBits(next());
+            if (corrupted)
+                return false;
+            glClearColor(r, g, b, a);
+            break;
+        }
+
+        case Command::Clear:
+        {
+            const GLbitfield mask = next();
+            if (corrupted)
+                return false;
+            glClear(mask);
+            break;
+        }
+
+        case Command::Enable:
+        {
+            const GLenum capability = next();
+            if (corrupted)
+                return false;
+            glEnable(capability);
+            break;
+        }
+
+        case Command::Disable:
+        {
+            const GLenum capability = next();
+            if (corrupted)
+                return false;
+            glDisable(capability);
+            break;
+        }
+
+        case Command::DrawElements:
+        {
+            const GLenum mode    = next();
+            const GLsizei count  = GLsizei(next());
+            const GLenum type    = next();
+            const GLsizeiptr offset = next();
+            if (corrupted)
+                return false;
+            glDrawElements(mode, count, type, (const GLvoid*) offset);
+            break;
+        }
+
+        case Command::DrawArrays:
+        {
+            const GLenum mode   = next();
+            const GLint first   = GLint(next());
+            const GLsizei count = GLsizei(next());
+            if (corrupted)
+                return false;
+            glDrawArrays(mode, first, count);
+            break;
+        }
+
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+/* ---------------------------------------------------------------- *
+   Constructs the player. The whole file is read and the header is
+   checked.
+ * ---------------------------------------------------------------- */
+TracePlayer::TracePlayer(const std::string& filePath)
+    : d(std::make_shared<Data>())
+{
+    std::ifstream file(filePath, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open trace file " << filePath
+                  << std::endl;
+        return;
+    }
+
+    d->bytes.assign(std::istreambuf_iterator<char>(file),
+                    std::istreambuf_iterator<char>());
+
+    std::uint32_t version = 0;
+    if (d->bytes.size() < sizeof(Magic) + 4 ||
+        std::memcmp(&d->bytes[0], Magic, sizeof(Magic)) != 0)
+    {
+        std::cerr << "File " << filePath << " is not a trace file"
+                  << std::endl;
+        return;
+    }
+
+    d->position = sizeof(Magic);
+    version = d->next();
+    if (version != Version)
+    {
+        std::cerr << "Unsupported trace version " << version
+                  << std::endl;
+        return;
+    }
+
+    d->valid = true;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns true if the trace file was read.
+ * ---------------------------------------------------------------- */
+bool TracePlayer::isValid() const
+{ return d->valid; }
+
+/* ---------------------------------------------------------------- *
+   Plays the commands until the end of the next frame.
+ * ---------------------------------------------------------------- */
+bool TracePlayer::playFrame()
+{
+    if (!d->valid)
+        return false;
+
+    while (d->position < d->bytes.size() && !d->corrupted)
+    {
+        const Trace::Command command =
+            Trace::Command(std::uint8_t(d->bytes[d->position++]));
+
+        if (!d->play(command))
+            d->corrupted = true;
+        else if (command == Trace::Command::EndFrame)
+            return !d->corrupted;
+    }
+
+    if (d->corrupted)
+        std::cerr << "Trace is corrupted at byte " << d->position
+                  << std::endl;
+    return false;
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the size of the last played frame.
+ * ---------------------------------------------------------------- */
+int TracePlayer::frameWidth() const
+{ return d->width; }
+
+int TracePlayer::frameHeight() const
+{ return d->height; }
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,236 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::Trace and
+           kuu::opengl::TracePlayer classes.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "opengl.h"
+#include "opengl_resource_registry.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   A recorder of the OpenGL command stream. The renderer issues its
+   OpenGL calls through the trace which forwards them into OpenGL
+   and, while recording, writes them into a binary trace file. The
+   object creations and deletions are recorded by the resource
+   registry so that the player can map the recorded object names
+   into its own names. Buffer data, texel data and shader sources
+   are recorded too, queries and state reads are not.
+
+   The trace is shared by the whole process. The recording must be
+   started before the OpenGL objects are created, e.g. before the
+   rendering thread is started. The recording stops when the given
+   count of frames is recorded or when stop() is called.
+
+   The trace file starts with a header of magic "KUUTRACE" and a
+   version. It is followed by the commands where a command is a
+   single byte code and 32-bit arguments in the native byte order.
+   Data and strings are stored with a 32-bit size prefix.
+
+   Example:
+
+    Trace& trace = Trace::instance();
+    trace.start("session.trace", 600);
+    ...
+    // rendering thread
+    trace.beginFrame(width, height);
+    trace.viewport(0, 0, width, height);
+    trace.clear(GL_COLOR_BUFFER_BIT);
+    ...
+    trace.endFrame();
+
+ * ---------------------------------------------------------------- */
+class Trace
+{
+public:
+    // Codes of the recorded commands.
+    enum class Command : std::uint8_t
+    {
+        BeginFrame = 1,
+        EndFrame,
+        CreateObject,
+        DeleteObject,
+        BufferData,
+        TexImage2D,
+        RenderbufferStorage,
+        BindVertexArray,
+        BindBuffer,
+        BindTexture,
+        BindRenderbuffer,
+        BindFramebuffer,
+        UseProgram,
+        ActiveTexture,
+        TexParameteri,
+        FramebufferTexture2D,
+        FramebufferRenderbuffer,
+        BlitFramebuffer,
+        EnableVertexAttribArray,
+        VertexAttribPointer,
+        ShaderSource,
+        CompileShader,
+        AttachShader,
+        LinkProgram,
+        UniformLocation,
+        Uniform1i,
+        Uniform2f,
+        UniformMatrix4fv,
+        Viewport,
+        ClearColor,
+        Clear,
+        Enable,
+        Disable,
+        DrawElements,
+        DrawArrays
+    };
+
+    // Returns the trace of the process.
+    static Trace& instance();
+
+    // Starts recording into the file. If the frame count is above
+    // zero then the recording stops after the count of frames.
+    // Returns false if the file could not be opened.
+    bool start(const std::string& filePath, int frameCount = 0);
+    // Stops recording and closes the file.
+    void stop();
+    // Returns true if recording.
+    bool isRecording() const;
+
+    // Marks the beginning and the end of a frame. The size is the
+    // size of the default framebuffer.
+    void beginFrame(int width, int height);
+    void endFrame();
+
+    // Records an object creation and deletion. Called by the
+    // resource registry. The type is the shader type of a shader.
+    void recordCreate(ResourceRegistry::Category category,
+                      GLuint name,
+                      GLenum type,
+                      const std::string& label);
+    void recordDelete(ResourceRegistry::Category category,
+                      GLuint name);
+
+    // Data stores. The object must be bound into the target.
+    void bufferData(GLuint buffer, GLenum target, GLsizeiptr size,
+                    const void* data, GLenum usage);
+    void texImage2D(GLuint texture, GLint internalFormat,
+                    GLsizei width, GLsizei height,
+                    GLenum format, GLenum type, const void* data);
+    void renderbufferStorage(GLuint renderbuffer, GLsizei samples,
+                             GLenum internalFormat,
+                             GLsizei width, GLsizei height);
+
+    // Bindings.
+    void bindVertexArray(GLuint vertexArray);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindTexture(GLenum target, GLuint texture);
+    void bindRenderbuffer(GLuint renderbuffer);
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+    void useProgram(GLuint program);
+    void activeTexture(GLenum unit);
+
+    // Texture parameters and framebuffer attachments.
+    void texParameteri(GLenum target, GLenum name, GLint param);
+    void framebufferTexture2D(GLenum target, GLenum attachment,
+                              GLenum textureTarget, GLuint texture,
+                              GLint level);
+    void framebufferRenderbuffer(GLenum target, GLenum attachment,
+                                 GLenum renderbufferTarget,
+                                 GLuint renderbuffer);
+    void blitFramebuffer(GLint srcX0, GLint srcY0,
+                         GLint srcX1, GLint srcY1,
+                         GLint dstX0, GLint dstY0,
+                         GLint dstX1, GLint dstY1,
+                         GLbitfield mask, GLenum filter);
+
+    // Vertex attributes. The offset is an offset into the buffer
+    // bound into GL_ARRAY_BUFFER.
+    void enableVertexAttribArray(GLuint index);
+    void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+                             GLboolean normalized, GLsizei stride,
+                             GLsizeiptr offset);
+
+    // Shaders and programs.
+    void shaderSource(GLuint shader, const std::string& source);
+    void compileShader(GLuint shader);
+    void attachShader(GLuint program, GLuint shader);
+    void linkProgram(GLuint program);
+    GLint uniformLocation(GLuint program, const std::string& name);
+
+    // Uniforms of the program in use.
+    void uniform1i(GLint location, GLint value);
+    void uniform2f(GLint location, GLfloat x, GLfloat y);
+    void uniformMatrix4fv(GLint location, const GLfloat* matrix);
+
+    // State and drawing. The offset is an offset into the buffer
+    // bound into GL_ELEMENT_ARRAY_BUFFER.
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+    void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+    void clear(GLbitfield mask);
+    void enable(GLenum capability);
+    void disable(GLenum capability);
+    void drawElements(GLenum mode, GLsizei count, GLenum type,
+                      GLsizeiptr offset);
+    void drawArrays(GLenum mode, GLint first, GLsizei count);
+
+private:
+    Trace();
+
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+/* ---------------------------------------------------------------- *
+   A player of the trace file. The whole file is read into memory
+   on construction so that the replay does not wait for the disk.
+   The recorded objects are created through the resource registry
+   and their names are mapped into the names of the player. The
+   default framebuffer of the trace is mapped into an offscreen
+   framebuffer that is resized to the recorded frame size.
+
+   The OpenGL context must be current when the frames are played
+   and when the player is destroyed. Objects that were not deleted
+   in the trace are deleted when the player is destroyed.
+
+   Example:
+
+    TracePlayer player("session.trace");
+    if (!player.isValid())
+        return EXIT_FAILURE;
+    while (player.playFrame())
+        glFinish();
+
+ * ---------------------------------------------------------------- */
+class TracePlayer
+{
+public:
+    // Constructs the player from the trace file. The errors are
+    // printed into standard error stream.
+    TracePlayer(const std::string& filePath);
+
+    // Returns true if the trace file was read.
+    bool isValid() const;
+
+    // Plays the commands until the end of the next frame. Returns
+    // false if the trace ended before the end of the frame.
+    bool playFrame();
+
+    // Returns the size of the last played frame.
+    int frameWidth() const;
+    int frameHeight() const;
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu
@@ -4,8 +4,11 @@
  * ---------------------------------------------------------------- */
 
 #include "opengl_widget.h"
+#include "opengl_startup.h"
 #include "opengl_thread.h"
 #include <iostream>
+#include <QtCore/QCoreApplication>
+#include <QtGui/QKeyEvent>
 #include <QtGui/QResizeEvent>
 
 namespace kuu
@@ -37,17 +40,20 @@ Widget::Widget(const QGLFormat& openglFormat)
 /* ---------------------------------------------------------------- *
    Starts the rendering thread. Before the thread can be start the
    current OpenGL context of the widget's surface must be moved from
-   UI thread into the new rendering thread.
+   UI thread into the new rendering thread. The rendering thread
+   moves it back when it exits.
  * -----------------------------------------------------------------*/
-void Widget::startThread()
+void Widget::startThread(const Thread::Settings& settings)
 {
     // Set the current context to be "no context".
     // Tell OpenGL to set "no context" as current context.
     doneCurrent();
 
-    // Create the rendering thread. Give in pointer to this widget
-    // as a shared pointer.
-    d->thread = std::make_shared<Thread>(shared_from_this());
+    // Create the rendering thread with the settings. Give in pointer
+    // to this widget as a shared pointer.
+    d->thread = std::make_shared<Thread>(shared_from_this(),
+                                         settings);
+    d->thread->setViewportSize(width(), height());
 
     // Move the OpenGL context into rendering thread.
     QGLContext* ctx = context();
@@ -63,6 +69,11 @@ void Widget::startThread()
     }
     ctx->moveToThread(d->thread.get());
 
+    // Link the shader programs of the scene with a shared context
+    // while the rendering thread presents the first frame. The shared
+    // context is created before the rendering thread is started.
+    Startup::instance().prepareShaders(ctx->contextHandle());
+
     // Start the rendering thread.
     d->thread->start();
 }
@@ -81,6 +92,56 @@ void Widget::stopThread()
     }
 }
 
+/* ---------------------------------------------------------------- *
+   Returns the rendering thread.
+ * ---------------------------------------------------------------- */
+Thread::Ptr Widget::renderThread() const
+{
+    return d->thread;
+}
+
+/* ---------------------------------------------------------------- *
+   Makes the widget context current in the calling thread.
+ * ---------------------------------------------------------------- */
+void Widget::makeCurrent()
+{
+    QGLWidget::makeCurrent();
+}
+
+/* ---------------------------------------------------------------- *
+   Swaps the widget buffers. Automatic buffer swap is disabled so
+   this is the only place where the swap happens.
+ * ---------------------------------------------------------------- */
+void Widget::swapBuffers()
+{
+    QGLWidget::swapBuffers();
+}
+
+/* ---------------------------------------------------------------- *
+   Sets "no context" as the current context.
+ * ---------------------------------------------------------------- */
+void Widget::doneCurrent()
+{
+    QGLWidget::doneCurrent();
+}
+
+/* ---------------------------------------------------------------- *
+   Moves the context back into the UI thread.
+ * ---------------------------------------------------------------- */
+void Widget::releaseContext()
+{
+    QThread* uiThread = QCoreApplication::instance()->thread();
+    context()->moveToThread(uiThread);
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the name of the backend.
+ * ---------------------------------------------------------------- */
+const char* Widget::backendName() const
+{
+    return "widget";
+}
+
 /* ---------------------------------------------------------------- *
    Resize event is disabled for the rendering thread to work.
  * ---------------------------------------------------------------- */
@@ -94,10 +155,15 @@ void Widget::resizeEvent(QResizeEvent* event)
 }
 
 /* ---------------------------------------------------------------- *
-   Paint event is disabled for the rendering thread to work.
+   Paint event is disabled for the rendering thread to work. The
+   rendering thread is asked to render a frame instead, this is
+   needed when the thread renders on-demand.
  * ---------------------------------------------------------------- */
 void Widget::paintEvent(QPaintEvent* /*event*/)
-{}
+{
+    if (d->thread)
+        d->thread->requestRender();
+}
 
 /* ---------------------------------------------------------------- *
    Close event stops the thread.
@@ -107,5 +173,48 @@ void Widget::closeEvent(QCloseEvent* /*event*/)
     stopThread();
 }
 
+/* ---------------------------------------------------------------- *
+   Show event resumes the thread.
+ * ---------------------------------------------------------------- */
+void Widget::showEvent(QShowEvent* /*event*/)
+{
+    if (d->thread)
+        d->thread->setPaused(isMinimized());
+}
+
+/* ---------------------------------------------------------------- *
+   Hide event pauses the thread.
+ * ---------------------------------------------------------------- */
+void Widget::hideEvent(QHideEvent* /*event*/)
+{
+    if (d->thread)
+        d->thread->setPaused(true);
+}
+
+/* ---------------------------------------------------------------- *
+   Window state change event pauses the thread when the widget is
+   minimized and resumes it when restored.
+ * ---------------------------------------------------------------- */
+void Widget::changeEvent(QEvent* event)
+{
+    if (event->type() == QEvent::WindowStateChange && d->thread)
+        d->thread->setPaused(isMinimized() || !isVisible());
+    QGLWidget::changeEvent(event);
+}
+
+/* ---------------------------------------------------------------- *
+   Key press event toggles the animation with space key and cycles
+   the anti-aliasing mode with A key.
+ * ---------------------------------------------------------------- */
+void Widget::keyPressEvent(QKeyEvent* event)
+{
+    if (event->key() == Qt::Key_Space && d->thread)
+        d->thread->setAnimating(!d->thread->isAnimating());
+    else if (event->key() == Qt::Key_A && d->thread)
+        d->thread->cycleAntiAliasing();
+    else
+        QGLWidget::keyPressEvent(event);
+}
+
 } // namespace opengl
 } // namespace kuu
@@ -13,6 +13,8 @@
     #include <QtOpenGL/QGLWidget>
     #include "opengl.h"
 #endif
+#include "opengl_surface.h"
+#include "opengl_thread.h"
 
 namespace kuu
 {
@@ -26,13 +28,15 @@ namespace opengl
    ing thread.
 
    The code below creates the widget with 3.3 core version of the
-   OpenGL and starts the rendering thread. Note that the widget
-   needs to be set visible before starting the thread.
+   OpenGL and starts the rendering thread. The default framebuffer
+   is single sampled as the anti-aliasing is done by the rendering
+   thread. Note that the widget needs to be set visible before
+   starting the thread.
 
         QGLFormat openglFormat;
         openglFormat.setVersion(3, 3);
         openglFormat.setProfile(QGLFormat::CoreProfile);
-        openglFormat.setSampleBuffers(true);
+        openglFormat.setSampleBuffers(false);
 
         using namespace kuu::opengl;
         Widget::Ptr widget = std::make_shared<Widget>(openglFormat);
@@ -42,12 +46,21 @@ namespace opengl
     The rendering thread must be stopped before the widget is de-
     stroyed. The rendering thread is stopped on close event.
 
+    The rendering thread is paused while the widget is hidden or
+    minimized. Space key starts and stops the animation.
+    A key cycles the anti-aliasing mode.
+
+    The widget goes through the QGLWidget composition. See the
+    kuu::opengl::Window class for a backend that renders directly
+    into a native window.
+
     Issues: resizing widget cause flickering. The issue might be
             cause by double-buffering.
 
  * ---------------------------------------------------------------- */
 class Widget
     : public QGLWidget
+    , public Surface
     , public std::enable_shared_from_this<Widget>
 {
 public:
@@ -58,16 +71,31 @@ public:
     // Constructs the widget.
     Widget(const QGLFormat& openglFormat);
 
-    // Starts the rendering thread.
-    void startThread();
+    // Starts the rendering thread with the settings.
+    void startThread(
+        const Thread::Settings& settings = Thread::Settings());
 
     // Stops the rendering thread.
     void stopThread();
 
+    // Returns the rendering thread or nullptr if not started.
+    Thread::Ptr renderThread() const;
+
+    // Surface interface, called from the rendering thread.
+    void makeCurrent();
+    void swapBuffers();
+    void doneCurrent();
+    void releaseContext();
+    const char* backendName() const;
+
 protected:
     void resizeEvent(QResizeEvent* event);
     void paintEvent(QPaintEvent* event);
     void closeEvent(QCloseEvent* event);
+    void showEvent(QShowEvent* event);
+    void hideEvent(QHideEvent* event);
+    void changeEvent(QEvent* event);
+    void keyPressEvent(QKeyEvent* event);
 
 private:
     struct Data;
@@ -0,0 +1,211 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Implementation of kuu::opengl::Window class.
+ * ---------------------------------------------------------------- */
+
+#include "opengl_window.h"
+#include "opengl_startup.h"
+#include "opengl_thread.h"
+#include <iostream>
+#include <QtCore/QCoreApplication>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QExposeEvent>
+#include <QtGui/QKeyEvent>
+#include <QtGui/QResizeEvent>
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   The data of the window. The context is created when the thread
+   is started for the first time. See startThread() for the crea-
+   tion of the context and the thread and stopThread() for the
+   destruction of the thread.
+
+   The surface is a non-owning handle of the window that is given
+   to the rendering thread. The window is owned either by a shared
+   pointer or by a window container so the handle does not delete
+   it. The handle is released when the window is destroyed.
+ * ---------------------------------------------------------------- */
+struct Window::Data
+{
+    std::shared_ptr<QOpenGLContext> context;
+    Surface::Ptr surface;
+    Thread::Ptr thread;
+};
+
+/* ---------------------------------------------------------------- *
+   Constructs the window from the given in OpenGL format.
+ * -----------------------------------------------------------------*/
+Window::Window(const QSurfaceFormat& openglFormat)
+    : d(std::make_shared<Data>())
+{
+    setSurfaceType(QWindow::OpenGLSurface);
+    setFormat(openglFormat);
+    d->surface = Surface::Ptr(this, [](Surface*) {});
+}
+
+/* ---------------------------------------------------------------- *
+   Destroys the window. The rendering thread is stopped before the
+   native window is destroyed by the QWindow destructor.
+ * -----------------------------------------------------------------*/
+Window::~Window()
+{
+    stopThread();
+    d->surface.reset();
+}
+
+/* ---------------------------------------------------------------- *
+   Starts the rendering thread. The OpenGL context is created in
+   the UI thread and then moved into the new rendering thread. The
+   rendering thread moves it back when it exits, so the thread can
+   be started again after stopThread(). The window must have been
+   created (e.g. shown) before this.
+ * -----------------------------------------------------------------*/
+void Window::startThread(const Thread::Settings& settings)
+{
+    if (!d->context)
+    {
+        d->context = std::make_shared<QOpenGLContext>();
+        d->context->setFormat(requestedFormat());
+        if (!d->context->create())
+        {
+            std::cerr << "Failed to create OpenGL context"
+                      << std::endl;
+            d->context.reset();
+            return;
+        }
+    }
+
+    // Link the shader programs of the scene with a shared context
+    // while the rendering thread presents the first frame. The shared
+    // context is created before the rendering thread is started.
+    Startup::instance().prepareShaders(d->context.get());
+
+    // Create the rendering thread with the settings. Give in the
+    // non-owning handle of this window.
+    d->thread = std::make_shared<Thread>(d->surface, settings);
+    d->thread->setViewportSize(width(), height());
+
+    // Move the OpenGL context into rendering thread.
+    d->context->moveToThread(d->thread.get());
+
+    // Start the rendering thread.
+    d->thread->start();
+}
+
+/* ---------------------------------------------------------------- *
+   Stops the rendering thread in case it has been created. The
+   shared pointer is reset so that this window can be destroyed
+   properly.
+ * -----------------------------------------------------------------*/
+void Window::stopThread()
+{
+    if (d->thread)
+    {
+        d->thread->stop();
+        d->thread.reset();
+    }
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the rendering thread.
+ * ---------------------------------------------------------------- */
+Thread::Ptr Window::renderThread() const
+{
+    return d->thread;
+}
+
+/* ---------------------------------------------------------------- *
+   Makes the window context current in the calling thread.
+ * ---------------------------------------------------------------- */
+void Window::makeCurrent()
+{
+    d->context->makeCurrent(this);
+}
+
+/* ---------------------------------------------------------------- *
+   Swaps the window buffers. The swap goes straight to the native
+   window.
+ * ---------------------------------------------------------------- */
+void Window::swapBuffers()
+{
+    d->context->swapBuffers(this);
+}
+
+/* ---------------------------------------------------------------- *
+   Sets "no context" as the current context.
+ * ---------------------------------------------------------------- */
+void Window::doneCurrent()
+{
+    d->context->doneCurrent();
+}
+
+/* ---------------------------------------------------------------- *
+   Moves the context back into the UI thread.
+ * ---------------------------------------------------------------- */
+void Window::releaseContext()
+{
+    QThread* uiThread = QCoreApplication::instance()->thread();
+    d->context->moveToThread(uiThread);
+}
+
+/* ---------------------------------------------------------------- *
+   Returns the name of the backend.
+ * ---------------------------------------------------------------- */
+const char* Window::backendName() const
+{
+    return "window";
+}
+
+/* ---------------------------------------------------------------- *
+   Resize event passes the new size to the rendering thread.
+ * ---------------------------------------------------------------- */
+void Window::resizeEvent(QResizeEvent* event)
+{
+    const QSize newSize = event->size();
+    if (d->thread)
+        d->thread->setViewportSize(
+            newSize.width(),
+            newSize.height());
+}
+
+/* ---------------------------------------------------------------- *
+   Expose event pauses the thread when the window is not exposed
+   and asks for a new frame when it is.
+ * ---------------------------------------------------------------- */
+void Window::exposeEvent(QExposeEvent* /*event*/)
+{
+    if (d->thread)
+        d->thread->setPaused(!isExposed());
+}
+
+/* ---------------------------------------------------------------- *
+   Key press event toggles the animation with space key and cycles
+   the anti-aliasing mode with A key.
+ * ---------------------------------------------------------------- */
+void Window::keyPressEvent(QKeyEvent* event)
+{
+    if (event->key() == Qt::Key_Space && d->thread)
+        d->thread->setAnimating(!d->thread->isAnimating());
+    else if (event->key() == Qt::Key_A && d->thread)
+        d->thread->cycleAntiAliasing();
+    else
+        QWindow::keyPressEvent(event);
+}
+
+/* ---------------------------------------------------------------- *
+   Close event stops the thread. QWindow does not have a close
+   event handler so the event is caught here.
+ * ---------------------------------------------------------------- */
+bool Window::event(QEvent* event)
+{
+    if (event->type() == QEvent::Close)
+        stopThread();
+    return QWindow::event(event);
+}
+
+} // namespace opengl
+} // namespace kuu
@@ -0,0 +1,100 @@
+/* ---------------------------------------------------------------- *
+   Author: Kuumies <kuumies@gmail.com>
+   Desc:   Definition of kuu::opengl::Window class.
+ * ---------------------------------------------------------------- */
+
+#pragma once
+
+#include <memory>
+#include <QtGui/QSurfaceFormat>
+#include <QtGui/QWindow>
+#include "opengl_surface.h"
+#include "opengl_thread.h"
+
+namespace kuu
+{
+namespace opengl
+{
+
+/* ---------------------------------------------------------------- *
+   An OpenGL window whose OpenGL context is updated by a non-UI
+   rendering thread. This is an alternative backend to the kuu::
+   opengl::Widget. The rendering thread draws and swaps directly
+   into the native window so there is no widget stack composition
+   nor a framebuffer copy in between.
+
+   The code below creates the window with 3.3 core version of the
+   OpenGL and starts the rendering thread. Like with the widget the
+   window needs to be set visible before starting the thread.
+
+        QSurfaceFormat openglFormat;
+        openglFormat.setVersion(3, 3);
+        openglFormat.setProfile(QSurfaceFormat::CoreProfile);
+
+        using namespace kuu::opengl;
+        Window::Ptr window = std::make_shared<Window>(openglFormat);
+        window->show();
+        window->startThread();
+
+   The window can be embedded into a widget hierarchy with the
+   QWidget::createWindowContainer. The container takes the owner-
+   ship of the window so the window must be created with new and
+   not held in a shared pointer. The rendering thread refers to the
+   window through a non-owning handle.
+
+        Window* window = new Window(openglFormat);
+        QWidget* container = QWidget::createWindowContainer(window);
+        container->show();
+        window->startThread();
+
+   The rendering thread is stopped on close event and at the latest
+   when the window is destroyed.
+
+   The rendering thread is paused while the window is not exposed,
+   e.g. when it is hidden, minimized or, on some platforms, fully
+   obscured. Space key starts and stops the animation.
+   A key cycles the anti-aliasing mode.
+ * ---------------------------------------------------------------- */
+class Window
+    : public QWindow
+    , public Surface
+{
+public:
+    // Defines a shared pointer of window.
+    using Ptr = std::shared_ptr<Window>;
+
+    // Constructs the window.
+    Window(const QSurfaceFormat& openglFormat);
+    // Destroys the window, the rendering thread is stopped.
+    ~Window();
+
+    // Starts the rendering thread with the settings.
+    void startThread(
+        const Thread::Settings& settings = Thread::Settings());
+
+    // Stops the rendering thread.
+    void stopThread();
+
+    // Returns the rendering thread or nullptr if not started.
+    Thread::Ptr renderThread() const;
+
+    // Surface interface, called from the rendering thread.
+    void makeCurrent();
+    void swapBuffers();
+    void doneCurrent();
+    void releaseContext();
+    const char* backendName() const;
+
+protected:
+    void resizeEvent(QResizeEvent* event);
+    void exposeEvent(QExposeEvent* event);
+    void keyPressEvent(QKeyEvent* event);
+    bool event(QEvent* event);
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+} // namespace opengl
+} // namespace kuu